@@ -1,4 +1,5 @@
 #include <iostream>
+#include <iterator>
 
 #include <GLFW/glfw3.h>
 
@@ -16,11 +17,27 @@ World world;
 namespace
 {
 const char *PROJECT_NAME = "TopDown";
+const char *STATS_FILE = "render_stats.csv";
+
+// NOTE: in the order of RenderPass, the GPU time columns follow it
+const char *RenderPassNames[] = {
+	"clear", "map", "frames", "particles", "text", "shapes", "textures",
+};
+static_assert(std::size(RenderPassNames) == static_cast<std::size_t>(RenderPass::Count));
+
+// NOTE: in the order of PostPass, F5 to F8 toggle the passes
+const char *PostPassNames[] = {
+	"bloom", "shake", "grade", "crt",
+};
+static_assert(std::size(PostPassNames) == static_cast<std::size_t>(PostPass::Count));
 const int WIDTH = 640;
 const int HEIGHT = 480;
 
 const int MaxStepsPerFrame = 5;
 const Time TimePerFrame = Time::microseconds(1000000ULL / 60ULL);
+const unsigned MaxParticles = 131072;
+const unsigned LoaderThreads = 2;
+const std::size_t LoaderBytesPerFrame = 4 << 20;
 }
 
 Application::Application()
@@ -28,7 +45,13 @@ Application::Application()
 	, mWindow()
 	, mRenderTarget()
 	, mUpdateTime(Time::Zero)
+	, mGameTime(Time::Zero)
 	, mNumFrames(0)
+	, mStateCounters()
+	, mRenderStats()
+	, mFrameTime(Time::Zero)
+	, mStatsFile()
+	, mStatsFrames(0)
 {
 	if (!glfwInit())
 	{
@@ -47,12 +70,51 @@ Application::run()
 	Clock clock;
 
 	mWindow.open(PROJECT_NAME, WIDTH, HEIGHT);
-	mRenderTarget.create(mWindow);
+	mRenderTarget.create(mWindow, true);
 	mEventQueue.registerWindow(mWindow);
 
-	world.textures.load(TextureID::TitleScreen, "assets/textures/pillars.jpg");
-	world.textures.load(TextureID::Entities, "assets/textures/Entities.png");
-	world.textures.load(TextureID::Explosion, "assets/textures/explosion.png");
+	// NOTE: the images are decoded while the first frames are drawn
+	if (!world.loader.create(LoaderThreads, LoaderBytesPerFrame))
+	{
+		throw std::runtime_error("Unable to create the texture loader");
+	}
+	world.textures.add(TextureID::TitleScreen, std::make_unique<Texture>());
+	if (!world.loader.load(world.textures.get(TextureID::TitleScreen),
+	                       "assets/textures/pillars.jpg",
+	                       false,
+	                       TextureCompression::Auto))
+	{
+		throw std::runtime_error("Unable to load the title screen");
+	}
+
+	// NOTE: prefer the atlas packed at build time by atlaspack
+	if (!world.atlas.loadFromCache("assets/atlas.tga",
+	                               "assets/atlas.frames",
+	                               "assets/sprites.txt")
+	    && !world.atlas.loadFromFile("assets/sprites.txt"))
+	{
+		throw std::runtime_error("Unable to build the sprite atlas");
+	}
+	world.atlas.setLayer(SPRITES_ATLAS);
+	if (!world.sprites.create(world.atlas.getWidth(), world.atlas.getHeight(), 1))
+	{
+		throw std::runtime_error("Unable to create the sprites texture");
+	}
+	world.sprites.setImage(SPRITES_ATLAS, world.atlas.getPixels(),
+	                       world.atlas.getWidth(), world.atlas.getHeight());
+	if (!world.map.loadFromFile("assets/levels/desert.txt", world.atlas, world.sprites))
+	{
+		throw std::runtime_error("Unable to load the map");
+	}
+	if (!world.debris.create(MaxParticles))
+	{
+		throw std::runtime_error("Unable to create the particles");
+	}
+	const auto windowSize = mWindow.getSize();
+	if (!world.post.create(windowSize.x, windowSize.y))
+	{
+		throw std::runtime_error("Unable to create the post processing");
+	}
 	world.fonts.load(FontID::Title, "assets/fonts/belligerent.ttf", 48);
 	world.fonts.load(FontID::Body, "assets/fonts/belligerent.ttf", 26);
 
@@ -84,8 +146,16 @@ Application::run()
 		render();
 	}
 
+	// NOTE: the states own GL objects, release them before the context
+	world.states.clearStack();
+	world.states.applyPendingChanges();
+	world.loader.destroy();
 	world.fonts.destroy();
 	world.textures.destroy();
+	world.sprites.destroy();
+	world.map.destroy();
+	world.debris.destroy();
+	world.post.destroy();
 	mRenderTarget.destroy();
 }
 
@@ -109,6 +179,7 @@ Application::processInput()
 		else if (const auto ev(std::get_if<WindowResized>(&event)); ev)
 		{
 			mRenderTarget.setViewport(ev->width, ev->height);
+			world.post.resize(ev->width, ev->height);
 		}
 		else if (const auto ev(std::get_if<WindowClosed>(&event)); ev)
 		{
@@ -122,7 +193,36 @@ Application::processInput()
 					  << "\nFPS: " << mNumFrames / mUpdateTime.asSeconds()
 					  << "\nFrame Length: "
 					  << (mUpdateTime / mNumFrames).asMicroseconds()
-					  << "\n";
+					  << "\nGL state changes: "
+					  << mStateCounters.issued
+					  << "\nGL state changes elided: "
+					  << mStateCounters.elided
+					  << "\nDraw calls: " << mRenderStats.drawCalls
+					  << "\nBatches: " << mRenderStats.batches
+					  << "\nVertices: " << mRenderStats.vertices
+					  << "\nBytes uploaded: " << mRenderStats.uploadedBytes
+					  << "\nGPU time (ms):";
+				for (unsigned pass = 0; pass < static_cast<unsigned>(RenderPass::Count); ++pass)
+				{
+					std::cout << "\n  " << RenderPassNames[pass] << ": "
+						  << mRenderTarget.getGpuTime(static_cast<RenderPass>(pass));
+				}
+				for (unsigned pass = 0; pass < static_cast<unsigned>(PostPass::Count); ++pass)
+				{
+					std::cout << "\n  " << PostPassNames[pass] << ": "
+						  << world.post.getGpuTime(static_cast<PostPass>(pass));
+				}
+				std::cout << "\n";
+			}
+			else if (ev->key == GLFW_KEY_F3)
+			{
+				toggleStatisticsDump();
+			}
+			else if (ev->key >= GLFW_KEY_F5 && ev->key <= GLFW_KEY_F8)
+			{
+				// NOTE: F5 to F8 toggle the post processing passes
+				const auto pass = static_cast<PostPass>(ev->key - GLFW_KEY_F5);
+				world.post.setEnabled(pass, !world.post.isEnabled(pass));
 			}
 			else if (ev->key == GLFW_KEY_ESCAPE)
 			{
@@ -154,14 +254,27 @@ Application::processInput()
 void
 Application::update(Time dt)
 {
+	mGameTime += dt;
 	world.states.update(dt.asSeconds());
+	world.post.update(dt.asSeconds());
 }
 
 void
 Application::render()
 {
+	world.loader.update();
+	mRenderTarget.beginFrame();
+	mRenderTarget.setTime(mGameTime.asSeconds());
+	world.post.begin(mRenderTarget);
 	world.states.draw(mRenderTarget);
+	world.post.end(mRenderTarget);
+	mRenderTarget.flush();
 	mWindow.display();
+
+	mStateCounters = GLState::getCounters();
+	GLState::resetCounters();
+	mRenderStats = mRenderTarget.getStats();
+	dumpStatistics();
 }
 
 void
@@ -178,4 +291,69 @@ Application::updateStatistics(Time dt)
 {
 	mUpdateTime += dt;
 	mNumFrames++;
+	mFrameTime = dt;
+}
+
+void
+Application::toggleStatisticsDump()
+{
+	if (mStatsFile.is_open())
+	{
+		mStatsFile.close();
+		std::cout << "Statistics saved in " << STATS_FILE << "\n";
+		return;
+	}
+
+	mStatsFile.open(STATS_FILE);
+	if (!mStatsFile)
+	{
+		std::cerr << "Application - Unable to open " << STATS_FILE << std::endl;
+		return;
+	}
+	mStatsFrames = 0;
+	mStatsFile << "frame,frame_us,draw_calls,batches,vertices,indices,"
+		"uploaded_bytes,texture_binds,program_switches,batch_splits,"
+		"largest_batch,gl_issued,gl_elided";
+	for (auto name : RenderPassNames)
+	{
+		mStatsFile << ",gpu_" << name << "_ms";
+	}
+	for (auto name : PostPassNames)
+	{
+		mStatsFile << ",gpu_" << name << "_ms";
+	}
+	mStatsFile << "\n";
+	std::cout << "Recording the statistics in " << STATS_FILE << "\n";
+}
+
+void
+Application::dumpStatistics()
+{
+	if (!mStatsFile.is_open())
+	{
+		return;
+	}
+
+	mStatsFile << mStatsFrames++ << ","
+	           << mFrameTime.asMicroseconds() << ","
+	           << mRenderStats.drawCalls << ","
+	           << mRenderStats.batches << ","
+	           << mRenderStats.vertices << ","
+	           << mRenderStats.indices << ","
+	           << mRenderStats.uploadedBytes << ","
+	           << mRenderStats.textureBinds << ","
+	           << mRenderStats.programSwitches << ","
+	           << mRenderStats.batchSplits << ","
+	           << mRenderStats.largestBatch << ","
+	           << mStateCounters.issued << ","
+	           << mStateCounters.elided;
+	for (unsigned pass = 0; pass < static_cast<unsigned>(RenderPass::Count); ++pass)
+	{
+		mStatsFile << "," << mRenderTarget.getGpuTime(static_cast<RenderPass>(pass));
+	}
+	for (unsigned pass = 0; pass < static_cast<unsigned>(PostPass::Count); ++pass)
+	{
+		mStatsFile << "," << world.post.getGpuTime(static_cast<PostPass>(pass));
+	}
+	mStatsFile << "\n";
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <fstream>
+
 #include "eventqueue.hpp"
+#include "glstate.hpp"
 #include "rendertarget.hpp"
 #include "time.hpp"
 #include "window.hpp"
@@ -21,11 +24,20 @@ private:
 
 	void registerStates();
 	void updateStatistics(Time dt);
+	void toggleStatisticsDump();
+	void dumpStatistics();
 
 private:
 	EventQueue    mEventQueue;
 	Window        mWindow;
 	RenderTarget  mRenderTarget;
 	Time          mUpdateTime;
+	Time          mGameTime;
 	std::size_t   mNumFrames;
+
+	GLState::Counters mStateCounters;
+	RenderStats       mRenderStats;
+	Time              mFrameTime;
+	std::ofstream     mStatsFile;
+	std::size_t       mStatsFrames;
 };
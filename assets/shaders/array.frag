@@ -0,0 +1,13 @@
+#version 330 core
+in vec2 FragUV;
+in vec4 FragColor;
+flat in float FragLayer;
+
+uniform sampler2DArray Texture;
+
+layout (location = 0) out vec4 OutColor;
+
+void main()
+{
+	OutColor = FragColor * texture(Texture, vec3(FragUV.st, FragLayer));
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+layout (location = 0) in vec2 Position;
+layout (location = 1) in vec2 UV;
+layout (location = 2) in vec4 Color;
+layout (location = 3) in float Layer;
+
+layout (std140) uniform Globals
+{
+	mat4 Projection;
+	mat4 View;
+	vec2 Viewport;
+	float Time;
+};
+
+out vec2 FragUV;
+out vec4 FragColor;
+flat out float FragLayer;
+
+void main()
+{
+	FragUV = UV;
+	FragColor = Color;
+	FragLayer = Layer;
+	gl_Position = Projection * View * vec4(Position, 0, 1);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+in vec2 FragUV;
+
+uniform sampler2D Texture;
+uniform sampler2D Bloom;
+uniform float Intensity;
+
+layout (location = 0) out vec4 OutColor;
+
+void main()
+{
+	vec3 color = texture(Texture, FragUV).rgb
+		+ texture(Bloom, FragUV).rgb * Intensity;
+	OutColor = vec4(color, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+in vec2 FragUV;
+
+uniform sampler2D Texture;
+uniform vec2 Direction;
+
+layout (location = 0) out vec4 OutColor;
+
+// NOTE: 9 taps gaussian folded in 5 bilinear fetches
+const float Offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float Weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main()
+{
+	vec3 color = texture(Texture, FragUV).rgb * Weights[0];
+	for (int i = 1; i < 3; ++i)
+	{
+		color += texture(Texture, FragUV + Direction * Offsets[i]).rgb * Weights[i];
+		color += texture(Texture, FragUV - Direction * Offsets[i]).rgb * Weights[i];
+	}
+	OutColor = vec4(color, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+in vec2 FragUV;
+
+uniform sampler2D Texture;
+uniform float Threshold;
+
+layout (location = 0) out vec4 OutColor;
+
+void main()
+{
+	vec3 color = texture(Texture, FragUV).rgb;
+	float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+	OutColor = vec4(color * smoothstep(Threshold, Threshold + 0.2, luma), 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+in vec2 FragUV;
+
+uniform sampler2D Texture;
+uniform vec2 Resolution;
+
+layout (location = 0) out vec4 OutColor;
+
+void main()
+{
+	vec3 color = texture(Texture, FragUV).rgb;
+
+	// darken every other row and the corners of the screen
+	float scanline = 0.8 + 0.2 * sin(FragUV.y * Resolution.y * 3.14159265);
+	vec2 centered = FragUV * 2.0 - 1.0;
+	float vignette = 1.0 - 0.25 * dot(centered, centered);
+	OutColor = vec4(color * scanline * vignette, 1.0);
+}
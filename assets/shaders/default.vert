@@ -4,7 +4,13 @@ layout (location = 0) in vec2 Position;
 layout (location = 1) in vec2 UV;
 layout (location = 2) in vec4 Color;
 
-uniform mat4 Projection;
+layout (std140) uniform Globals
+{
+	mat4 Projection;
+	mat4 View;
+	vec2 Viewport;
+	float Time;
+};
 
 out vec2 FragUV;
 out vec4 FragColor;
@@ -13,5 +19,5 @@ void main()
 {
 	FragUV = UV;
 	FragColor = Color;
-	gl_Position = Projection * vec4(Position, 0, 1);
+	gl_Position = Projection * View * vec4(Position, 0, 1);
 }
@@ -0,0 +1,18 @@
+#version 330 core
+in vec2 FragUV;
+
+uniform sampler2D Texture;
+uniform float Saturation;
+uniform float Contrast;
+uniform vec3 Tint;
+
+layout (location = 0) out vec4 OutColor;
+
+void main()
+{
+	vec3 color = texture(Texture, FragUV).rgb;
+	float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+	color = mix(vec3(luma), color, Saturation);
+	color = (color - 0.5) * Contrast + 0.5;
+	OutColor = vec4(clamp(color * Tint, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,48 @@
+#version 330 core
+
+layout (location = 0) in vec2 Position;
+layout (location = 2) in float Spawn;
+layout (location = 3) in float Life;
+
+layout (std140) uniform Globals
+{
+	mat4 Projection;
+	mat4 View;
+	vec2 Viewport;
+	float Time;
+};
+
+const int MAX_FRAMES = 32;
+
+uniform float Now;
+uniform vec4 Frames[MAX_FRAMES];
+uniform int FrameCount;
+uniform vec2 Size;
+uniform float Layer;
+
+out vec2 FragUV;
+out vec4 FragColor;
+flat out float FragLayer;
+
+void main()
+{
+	// dead particles collapse to a point and are not rasterized
+	float age = (Now - Spawn) / max(Life, 1e-6);
+	if (Life <= 0.0 || age >= 1.0)
+	{
+		FragUV = vec2(0.0);
+		FragColor = vec4(0.0);
+		FragLayer = Layer;
+		gl_Position = vec4(0.0);
+		return;
+	}
+
+	// expand the unit quad from the vertex index of the strip and
+	// pick the frame of the flipbook from the age
+	vec2 unit = vec2(gl_VertexID >> 1, gl_VertexID & 1);
+	vec4 frame = Frames[min(int(age * float(FrameCount)), FrameCount - 1)];
+	FragUV = frame.xy + frame.zw * unit;
+	FragColor = vec4(1.0);
+	FragLayer = Layer;
+	gl_Position = Projection * View * vec4(Position + Size * (unit - 0.5), 0, 1);
+}
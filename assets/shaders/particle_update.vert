@@ -0,0 +1,22 @@
+#version 330 core
+
+layout (location = 0) in vec2 Position;
+layout (location = 1) in vec2 Velocity;
+layout (location = 2) in float Spawn;
+layout (location = 3) in float Life;
+
+uniform float DeltaTime;
+uniform float Drag;
+
+out vec2 OutPosition;
+out vec2 OutVelocity;
+out float OutSpawn;
+out float OutLife;
+
+void main()
+{
+	OutVelocity = Velocity * max(1.0 - Drag * DeltaTime, 0.0);
+	OutPosition = Position + OutVelocity * DeltaTime;
+	OutSpawn = Spawn;
+	OutLife = Life;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+uniform float FlipY;
+
+out vec2 FragUV;
+
+void main()
+{
+	// one triangle covering the screen, the rows of the textures go
+	// upwards so the window flips them
+	vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	FragUV = vec2(pos.x, mix(pos.y, 1.0 - pos.y, FlipY));
+	gl_Position = vec4(pos * 2.0 - 1.0, 0, 1);
+}
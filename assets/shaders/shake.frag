@@ -0,0 +1,12 @@
+#version 330 core
+in vec2 FragUV;
+
+uniform sampler2D Texture;
+uniform vec2 Offset;
+
+layout (location = 0) out vec4 OutColor;
+
+void main()
+{
+	OutColor = vec4(texture(Texture, FragUV + Offset).rgb, 1.0);
+}
@@ -3,10 +3,16 @@ layout (location = 0) in vec2 pos;
 layout (location = 1) in vec2 uv;
 
 out vec2 TexCoords;
-uniform mat4 projection;
+layout (std140) uniform Globals
+{
+	mat4 Projection;
+	mat4 View;
+	vec2 Viewport;
+	float Time;
+};
 
 void main()
 {
-	gl_Position = projection * vec4(pos, 0.0, 1.0);
+	gl_Position = Projection * View * vec4(pos, 0.0, 1.0);
 	TexCoords = uv;
 }
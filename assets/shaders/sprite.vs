@@ -0,0 +1,30 @@
+#version 330 core
+layout (location = 0) in vec2 Position;
+layout (location = 1) in vec2 AxisX;
+layout (location = 2) in vec2 AxisY;
+layout (location = 3) in vec2 UVPos;
+layout (location = 4) in vec2 UVSize;
+layout (location = 5) in vec4 Color;
+layout (location = 6) in float Layer;
+
+layout (std140) uniform Globals
+{
+	mat4 Projection;
+	mat4 View;
+	vec2 Viewport;
+	float Time;
+};
+
+out vec2 FragUV;
+out vec4 FragColor;
+flat out float FragLayer;
+
+void main()
+{
+	// expand the unit quad from the vertex index of the strip
+	vec2 unit = vec2(gl_VertexID >> 1, gl_VertexID & 1);
+	FragUV = UVPos + UVSize * unit;
+	FragColor = Color;
+	FragLayer = Layer;
+	gl_Position = Projection * View * vec4(Position + AxisX * unit.x + AxisY * unit.y, 0, 1);
+}
@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "atlas.hpp"
+#include "stb_image.h"
+
+namespace
+{
+// NOTE: transparent border around each frame to avoid bleeding
+const int PADDING = 1;
+const unsigned MIN_SIZE = 256;
+
+struct ImageDeleter
+{
+	void operator()(unsigned char *pixels) const
+	{
+		stbi_image_free(pixels);
+	}
+};
+
+struct Image
+{
+	std::unique_ptr<unsigned char, ImageDeleter> pixels;
+	int width;
+	int height;
+};
+
+struct Sprite
+{
+	std::string name;
+	unsigned image;
+	IntRect src;
+	IntRect dst;
+};
+
+static bool
+containsRect(const IntRect &a, const IntRect &b)
+{
+	return a.pos.x <= b.pos.x && a.pos.y <= b.pos.y
+		&& b.pos.x + b.size.x <= a.pos.x + a.size.x
+		&& b.pos.y + b.size.y <= a.pos.y + a.size.y;
+}
+
+/**
+ * MaxRects bin packer with the best short side fit heuristic.
+ */
+class MaxRects
+{
+public:
+	explicit MaxRects(int size)
+		: mFree{ IntRect(glm::ivec2(0), glm::ivec2(size)) }
+	{
+	}
+
+	bool insert(glm::ivec2 size, IntRect &result)
+	{
+		int bestShort = INT_MAX;
+		int bestLong = INT_MAX;
+		for (const auto &free : mFree)
+		{
+			if (free.size.x < size.x || free.size.y < size.y)
+			{
+				continue;
+			}
+			const auto left = free.size - size;
+			const int shortSide = std::min(left.x, left.y);
+			const int longSide = std::max(left.x, left.y);
+			if (shortSide < bestShort
+			    || (shortSide == bestShort && longSide < bestLong))
+			{
+				bestShort = shortSide;
+				bestLong = longSide;
+				result = IntRect(free.pos, size);
+			}
+		}
+		if (bestShort == INT_MAX)
+		{
+			return false;
+		}
+		split(result);
+		prune();
+		return true;
+	}
+
+private:
+	void split(const IntRect &used)
+	{
+		std::vector<IntRect> result;
+		const auto usedEnd = used.pos + used.size;
+		for (auto &free : mFree)
+		{
+			if (!free.overlaps(used))
+			{
+				result.push_back(free);
+				continue;
+			}
+
+			// keep the parts of the free rectangle around the used one
+			const auto freeEnd = free.pos + free.size;
+			if (used.pos.x > free.pos.x)
+			{
+				result.emplace_back(
+					free.pos,
+					glm::ivec2(used.pos.x - free.pos.x, free.size.y));
+			}
+			if (usedEnd.x < freeEnd.x)
+			{
+				result.emplace_back(
+					glm::ivec2(usedEnd.x, free.pos.y),
+					glm::ivec2(freeEnd.x - usedEnd.x, free.size.y));
+			}
+			if (used.pos.y > free.pos.y)
+			{
+				result.emplace_back(
+					free.pos,
+					glm::ivec2(free.size.x, used.pos.y - free.pos.y));
+			}
+			if (usedEnd.y < freeEnd.y)
+			{
+				result.emplace_back(
+					glm::ivec2(free.pos.x, usedEnd.y),
+					glm::ivec2(free.size.x, freeEnd.y - usedEnd.y));
+			}
+		}
+		mFree.swap(result);
+	}
+
+	void prune()
+	{
+		for (std::size_t i = 0; i < mFree.size(); ++i)
+		{
+			for (std::size_t j = 0; j < mFree.size(); ++j)
+			{
+				if (i != j && containsRect(mFree[j], mFree[i]))
+				{
+					mFree.erase(mFree.begin() + i);
+					--i;
+					break;
+				}
+			}
+		}
+	}
+
+private:
+	std::vector<IntRect> mFree;
+};
+
+static bool
+packSprites(std::vector<Sprite> &sprites, int size)
+{
+	MaxRects packer(size);
+	for (auto &sprite : sprites)
+	{
+		IntRect rect;
+		if (!packer.insert(sprite.src.size + glm::ivec2(2 * PADDING), rect))
+		{
+			return false;
+		}
+		sprite.dst = IntRect(rect.pos + glm::ivec2(PADDING), sprite.src.size);
+	}
+	return true;
+}
+
+static std::vector<std::filesystem::path>
+getSources(const std::filesystem::path &spriteList)
+{
+	// NOTE: the list itself and every image it names
+	std::vector<std::filesystem::path> sources{ spriteList };
+	std::ifstream in(spriteList);
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::istringstream entry(line);
+		std::string kind, name, file;
+		if ((entry >> kind >> name >> file) && kind[0] != '#')
+		{
+			sources.push_back(spriteList.parent_path() / file);
+		}
+	}
+	return sources;
+}
+}
+
+Atlas::Atlas()
+	: mFrames()
+	, mRects()
+	, mPixels()
+	, mWidth(0)
+	, mHeight(0)
+	, mLayer(0)
+{
+}
+
+bool
+Atlas::loadFromFile(const std::filesystem::path &spriteList, unsigned maxSize)
+{
+	std::ifstream in(spriteList);
+	if (!in)
+	{
+		std::cerr << "Atlas::loadFromFile() - Unable to open "
+		          << spriteList.string() << std::endl;
+		return false;
+	}
+
+	// parse the list and decode each image once
+	std::vector<Image> images;
+	std::unordered_map<std::string, unsigned> imageIndex;
+	std::vector<Sprite> sprites;
+	std::string line;
+	for (unsigned lineNumber = 1; std::getline(in, line); ++lineNumber)
+	{
+		std::istringstream entry(line);
+		std::string kind, name, file;
+		IntRect src;
+		int count = 1;
+		if (!(entry >> kind) || kind[0] == '#')
+		{
+			continue;
+		}
+		entry >> name >> file >> src.pos.x >> src.pos.y >> src.size.x >> src.size.y;
+		if (kind == "strip")
+		{
+			entry >> count;
+		}
+		if (!entry || (kind != "sprite" && kind != "strip")
+		    || src.size.x <= 0 || src.size.y <= 0 || count <= 0)
+		{
+			std::cerr << "Atlas::loadFromFile() - Invalid entry at "
+			          << spriteList.string() << ":" << lineNumber
+			          << std::endl;
+			return false;
+		}
+
+		auto [it, added] = imageIndex.try_emplace(file, images.size());
+		if (added)
+		{
+			const auto path = spriteList.parent_path() / file;
+			int w, h, channels;
+			auto *pixels = stbi_load(path.c_str(), &w, &h, &channels, 4);
+			if (pixels == nullptr)
+			{
+				std::cerr << "Atlas::loadFromFile() - Unable to load "
+				          << path.string() << std::endl;
+				return false;
+			}
+			images.emplace_back(
+				std::unique_ptr<unsigned char, ImageDeleter>(pixels), w, h);
+		}
+
+		const auto &image = images[it->second];
+		const int columns = std::max(1, (image.width - src.pos.x) / src.size.x);
+		for (int i = 0; i < count; ++i)
+		{
+			Sprite sprite;
+			sprite.name = kind == "strip" ? name + "_" + std::to_string(i) : name;
+			sprite.image = it->second;
+			sprite.src.pos = src.pos + glm::ivec2(i % columns, i / columns) * src.size;
+			sprite.src.size = src.size;
+			if (sprite.src.pos.x + sprite.src.size.x > image.width
+			    || sprite.src.pos.y + sprite.src.size.y > image.height)
+			{
+				std::cerr << "Atlas::loadFromFile() - Frame " << sprite.name
+				          << " outside of " << file << std::endl;
+				return false;
+			}
+			sprites.push_back(std::move(sprite));
+		}
+	}
+
+	// NOTE: the packer works best with the tallest sprites first
+	std::stable_sort(sprites.begin(), sprites.end(), [](const auto &a, const auto &b) {
+		if (a.src.size.y != b.src.size.y)
+		{
+			return a.src.size.y > b.src.size.y;
+		}
+		return a.src.size.x > b.src.size.x;
+	});
+
+	unsigned size = MIN_SIZE;
+	while (!packSprites(sprites, size))
+	{
+		size *= 2;
+		if (size > maxSize)
+		{
+			std::cerr << "Atlas::loadFromFile() - The sprites do not fit in "
+			          << maxSize << "x" << maxSize << std::endl;
+			return false;
+		}
+	}
+
+	mWidth = mHeight = size;
+	mPixels.assign(mWidth * mHeight * 4, 0);
+	mFrames.clear();
+	mRects.clear();
+	for (const auto &sprite : sprites)
+	{
+		if (mRects.count(sprite.name))
+		{
+			std::cerr << "Atlas::loadFromFile() - Duplicate frame "
+			          << sprite.name << std::endl;
+			return false;
+		}
+		const auto &image = images[sprite.image];
+		for (int y = 0; y < sprite.src.size.y; ++y)
+		{
+			const auto *src = image.pixels.get()
+				+ ((sprite.src.pos.y + y) * image.width + sprite.src.pos.x) * 4;
+			auto *dst = mPixels.data()
+				+ ((sprite.dst.pos.y + y) * mWidth + sprite.dst.pos.x) * 4;
+			std::copy(src, src + sprite.src.size.x * 4, dst);
+		}
+		addFrame(sprite.name, sprite.dst);
+	}
+	return true;
+}
+
+bool
+Atlas::loadFromCache(const std::filesystem::path &image,
+                     const std::filesystem::path &table,
+                     const std::filesystem::path &spriteList)
+{
+	// NOTE: the cache is stale when any source changed after it
+	std::error_code ec;
+	auto sourceTime = std::filesystem::file_time_type::min();
+	for (const auto &path : getSources(spriteList))
+	{
+		sourceTime = std::max(sourceTime, std::filesystem::last_write_time(path, ec));
+		if (ec)
+		{
+			return false;
+		}
+	}
+	for (const auto &path : { image, table })
+	{
+		const auto time = std::filesystem::last_write_time(path, ec);
+		if (ec || time < sourceTime)
+		{
+			return false;
+		}
+	}
+
+	std::ifstream in(table);
+	std::string magic;
+	unsigned width = 0, height = 0;
+	if (!(in >> magic >> width >> height) || magic != "atlas")
+	{
+		std::cerr << "Atlas::loadFromCache() - Invalid table "
+		          << table.string() << std::endl;
+		return false;
+	}
+
+	int w, h, channels;
+	auto *pixels = stbi_load(image.c_str(), &w, &h, &channels, 4);
+	if (pixels == nullptr)
+	{
+		std::cerr << "Atlas::loadFromCache() - Unable to load "
+		          << image.string() << std::endl;
+		return false;
+	}
+	if (static_cast<unsigned>(w) != width || static_cast<unsigned>(h) != height)
+	{
+		std::cerr << "Atlas::loadFromCache() - Size mismatch between "
+		          << image.string() << " and " << table.string() << std::endl;
+		stbi_image_free(pixels);
+		return false;
+	}
+	mWidth = width;
+	mHeight = height;
+	mPixels.assign(pixels, pixels + width * height * 4);
+	stbi_image_free(pixels);
+
+	mFrames.clear();
+	mRects.clear();
+	std::string name;
+	IntRect rect;
+	while (in >> name >> rect.pos.x >> rect.pos.y >> rect.size.x >> rect.size.y)
+	{
+		addFrame(name, rect);
+	}
+	return true;
+}
+
+bool
+Atlas::saveToFiles(const std::filesystem::path &image,
+                   const std::filesystem::path &table) const
+{
+	std::ofstream img(image, std::ios::binary);
+	if (!img)
+	{
+		std::cerr << "Atlas::saveToFiles() - Unable to open "
+		          << image.string() << std::endl;
+		return false;
+	}
+
+	// NOTE: uncompressed 32bpp TGA with the origin at the top left
+	const char header[18] = {
+		0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		static_cast<char>(mWidth & 0xFF),
+		static_cast<char>(mWidth >> 8),
+		static_cast<char>(mHeight & 0xFF),
+		static_cast<char>(mHeight >> 8),
+		32, 0x28,
+	};
+	img.write(header, sizeof(header));
+	std::vector<char> bgra(mPixels.size());
+	for (std::size_t i = 0; i < mPixels.size(); i += 4)
+	{
+		bgra[i + 0] = mPixels[i + 2];
+		bgra[i + 1] = mPixels[i + 1];
+		bgra[i + 2] = mPixels[i + 0];
+		bgra[i + 3] = mPixels[i + 3];
+	}
+	img.write(bgra.data(), bgra.size());
+
+	std::ofstream out(table);
+	if (!out)
+	{
+		std::cerr << "Atlas::saveToFiles() - Unable to open "
+		          << table.string() << std::endl;
+		return false;
+	}
+
+	// sort the names to keep the output stable
+	std::vector<std::string> names;
+	for (const auto &[name, _] : mRects)
+	{
+		names.push_back(name);
+	}
+	std::sort(names.begin(), names.end());
+
+	out << "atlas " << mWidth << " " << mHeight << "\n";
+	for (const auto &name : names)
+	{
+		const auto &rect = mRects.at(name);
+		out << name << " "
+		    << rect.pos.x << " " << rect.pos.y << " "
+		    << rect.size.x << " " << rect.size.y << "\n";
+	}
+	return img.good() && out.good();
+}
+
+void
+Atlas::setLayer(unsigned layer)
+{
+	mLayer = layer;
+	for (auto &[_, frame] : mFrames)
+	{
+		frame.layer = layer;
+	}
+}
+
+const Frame &
+Atlas::getFrame(const std::string &name) const
+{
+	auto found = mFrames.find(name);
+	if (found == mFrames.end())
+	{
+		throw std::runtime_error("Atlas::getFrame() - Frame "
+		                         + name + " not found");
+	}
+	return found->second;
+}
+
+unsigned
+Atlas::getWidth() const
+{
+	return mWidth;
+}
+
+unsigned
+Atlas::getHeight() const
+{
+	return mHeight;
+}
+
+const std::uint8_t *
+Atlas::getPixels() const
+{
+	return mPixels.data();
+}
+
+void
+Atlas::addFrame(const std::string &name, const IntRect &rect)
+{
+	const glm::vec2 atlasSize(mWidth, mHeight);
+	mRects[name] = rect;
+	mFrames[name] = Frame{
+		glm::vec2(rect.size),
+		glm::vec2(rect.pos) / atlasSize,
+		glm::vec2(rect.size) / atlasSize,
+		mLayer,
+	};
+}
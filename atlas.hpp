@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "frame.hpp"
+#include "rect.hpp"
+
+/**
+ * Sprite atlas packed from a list of images.
+ *
+ * The sprite list has one entry per line:
+ *
+ *   sprite <name> <image> <x> <y> <width> <height>
+ *   strip  <name> <image> <x> <y> <width> <height> <count>
+ *
+ * A strip is a sequence of @count frames laid out left to right and
+ * top to bottom in the image, its frames are named <name>_<index>.
+ * The image paths are relative to the sprite list.
+ *
+ * The frames are packed with a MaxRects packer in the smallest power
+ * of two square which holds them all; the result can be saved and
+ * loaded back to skip the packing at startup.
+ */
+class Atlas
+{
+public:
+	Atlas();
+
+	/**
+	 * Pack the sprites listed in the @spriteList file.
+	 * @param[in] maxSize the maximum width and height of the atlas
+	 */
+	bool loadFromFile(const std::filesystem::path &spriteList,
+	                  unsigned maxSize = 2048);
+
+	/**
+	 * Load a packed atlas saved by saveToFiles(), the @image and
+	 * the @table are rejected when older than the @spriteList or
+	 * any of the images it lists.
+	 */
+	bool loadFromCache(const std::filesystem::path &image,
+	                   const std::filesystem::path &table,
+	                   const std::filesystem::path &spriteList);
+
+	/**
+	 * Save the pixels as an uncompressed TGA @image and the frame
+	 * rectangles in the text @table.
+	 */
+	bool saveToFiles(const std::filesystem::path &image,
+	                 const std::filesystem::path &table) const;
+
+	/**
+	 * Set the TextureArray @layer of the frames.
+	 */
+	void setLayer(unsigned layer);
+
+	/**
+	 * Get the frame called @name.
+	 * @throw std::runtime_error if the frame does not exist
+	 */
+	const Frame &getFrame(const std::string &name) const;
+
+	unsigned getWidth() const;
+	unsigned getHeight() const;
+	const std::uint8_t *getPixels() const;
+
+private:
+	void addFrame(const std::string &name, const IntRect &rect);
+
+private:
+	std::unordered_map<std::string, Frame>   mFrames;
+	std::unordered_map<std::string, IntRect> mRects;
+	std::vector<std::uint8_t> mPixels;
+	unsigned mWidth;
+	unsigned mHeight;
+	unsigned mLayer;
+};
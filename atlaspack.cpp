@@ -0,0 +1,21 @@
+#include <iostream>
+
+#include "atlas.hpp"
+
+int
+main(int argc, char *argv[])
+{
+	if (argc != 4)
+	{
+		std::cerr << "Usage: " << argv[0]
+		          << " <sprite list> <atlas.tga> <atlas table>" << std::endl;
+		return 1;
+	}
+
+	Atlas atlas;
+	if (!atlas.loadFromFile(argv[1]) || !atlas.saveToFiles(argv[2], argv[3]))
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -32,6 +32,7 @@ Font::Font()
 	, mPositionX(0)
 	, mPositionY(0)
 	, mMaxHeight(0)
+	, mGeneration(0)
 {
 }
 
@@ -66,6 +67,7 @@ Font::loadFromFile(const std::filesystem::path &path, unsigned size)
 		mFace->size->metrics.descender) / 64.f;
 	mGlyphs.clear();
 	mPositionX = mPositionY = mMaxHeight = 0;
+	mGeneration++;
 
 	return true;
 }
@@ -78,6 +80,9 @@ Font::destroy()
 	mFace = nullptr;
 	mFT = nullptr;
 	mTexture.destroy();
+	mGlyphs.clear();
+	mPositionX = mPositionY = mMaxHeight = 0;
+	mGeneration++;
 }
 
 glm::vec2
@@ -106,6 +111,7 @@ Font::resizeTexture(unsigned newWidth, unsigned newHeight)
 
 	Texture newTexture;
 	newTexture.create(newWidth, newHeight, nullptr, false, true);
+	mTexture.commit();
 	newTexture.update(mTexture);
 	std::swap(mTexture, newTexture);
 
@@ -118,6 +124,7 @@ Font::resizeTexture(unsigned newWidth, unsigned newHeight)
 		glyph.uvPos *= scale;
 		glyph.uvSize *= scale;
 	}
+	mGeneration++;
 }
 
 const Glyph&
@@ -207,7 +214,7 @@ Font::getGlyph(char32_t codepoint)
 	}
 
 	// upload the data
-	mTexture.update(mPixelBuffer.data(), mPositionX, mPositionY, bmWidth, bmHeight);
+	mTexture.stage(mPixelBuffer.data(), mPositionX, mPositionY, bmWidth, bmHeight);
 
 	bmWidth -= 2 * PADDING;
 	bmHeight -= 2 * PADDING;
@@ -246,3 +253,15 @@ Font::getLineHeight() const
 {
 	return mLineHeight;
 }
+
+unsigned
+Font::getGeneration() const
+{
+	return mGeneration;
+}
+
+void
+Font::commit()
+{
+	mTexture.commit();
+}
@@ -41,6 +41,18 @@ public:
 	const Texture &getTexture() const;
 	float getLineHeight() const;
 
+	/**
+	 * Get a counter which changes whenever the UVs of the glyphs
+	 * already rendered are no longer valid.
+	 */
+	unsigned getGeneration() const;
+
+	/**
+	 * Upload the glyphs rendered since the last call, it must be
+	 * called before drawing with the texture.
+	 */
+	void commit();
+
 private:
 	void resizeTexture(unsigned newWidth, unsigned newHeight);
 
@@ -54,4 +66,5 @@ private:
 	int mPositionX;
 	int mPositionY;
 	int mMaxHeight;
+	unsigned mGeneration;
 };
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/**
+ * Rectangle of a sprite in a texture.
+ *
+ * The UV coordinates are normalized, @layer selects the image when
+ * the frame is drawn from a TextureArray.
+ */
+struct Frame
+{
+	glm::vec2 size;
+	glm::vec2 uvPos;
+	glm::vec2 uvSize;
+	unsigned layer = 0;
+};
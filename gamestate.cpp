@@ -1,4 +1,5 @@
 #include <array>
+#include <string>
 
 #include <GLFW/glfw3.h>
 
@@ -24,171 +25,26 @@ enum
 	FRAME_ENEMYBULLET,
 };
 
-constexpr std::array frames = {
-	Frame{
-		{ 48.f, 64.f },
-		{  0.f / 288.f,  0.f / 104.f },
-		{ 48.f / 288.f, 64.f / 104.f },
-	},
-	Frame{
-		{ 48.f, 64.f },
-		{ 48.f / 288.f,  0.f / 104.f },
-		{ 48.f / 288.f, 64.f / 104.f },
-	},
-	Frame{
-		{ 48.f, 64.f },
-		{ 96.f / 288.f,  0.f / 104.f },
-		{ 48.f / 288.f, 64.f / 104.f },
-	},
-	Frame{
-		{ 84.f, 64.f },
-		{ 144.f / 288.f,  0.f / 104.f },
-		{  84.f / 288.f, 64.f / 104.f },
-	},
-	Frame{
-		{ 60.f, 64.f },
-		{ 228.f / 288.f,  0.f / 104.f },
-		{  60.f / 288.f, 64.f / 104.f },
-	},
-	Frame{
-		{ 40.f, 40.f },
-		{  0.f / 288.f, 64.f / 104.f },
-		{ 40.f / 288.f, 40.f / 104.f },
-	},
-	Frame{
-		{ 40.f, 40.f },
-		{ 40.f / 288.f, 64.f / 104.f },
-		{ 40.f / 288.f, 40.f / 104.f },
-	},
-	Frame{
-		{ 40.f, 40.f },
-		{ 80.f / 288.f, 64.f / 104.f },
-		{ 40.f / 288.f, 40.f / 104.f },
-	},
-	Frame{
-		{ 40.f, 40.f },
-		{ 120.f / 288.f, 64.f / 104.f },
-		{  40.f / 288.f, 40.f / 104.f },
-	},
-	Frame{
-		{ 15.f, 32.f },
-		{ 160.f / 288.f, 64.f / 104.f },
-		{  15.f / 288.f, 32.f / 104.f },
-	},
-	Frame{
-		{ 3.f, 14.f },
-		{ 175.f / 288.f, 64.f / 104.f },
-		{   3.f / 288.f, 14.f / 104.f },
-	},
-	Frame{
-		{ 3.f, 14.f },
-		{ 178.f / 288.f, 64.f / 104.f },
-		{   3.f / 288.f, 14.f / 104.f },
-	}
+// NOTE: names of the frames in the sprite atlas, same order as FRAME_*
+constexpr std::array frameNames = {
+	"player_center",
+	"player_right",
+	"player_left",
+	"enemy1",
+	"enemy2",
+	"health_pow",
+	"missile_pow",
+	"doublegun_pow",
+	"fastergun_pow",
+	"missile",
+	"player_bullet",
+	"enemy_bullet",
 };
 
-constexpr std::array expFrames = {
-	Frame{
-		{ 96.f, 96.f },
-		{   0.f / 480.f,   0.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{  96.f / 480.f,   0.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 192.f / 480.f,   0.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 288.f / 480.f,   0.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 384.f / 480.f,   0.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{   0.f / 480.f,  96.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{  96.f / 480.f,  96.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 192.f / 480.f,  96.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 288.f / 480.f,  96.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 384.f / 480.f,  96.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{   0.f / 480.f, 192.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{  96.f / 480.f, 192.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 192.f / 480.f, 192.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 288.f / 480.f, 192.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 384.f / 480.f, 192.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{   0.f / 480.f, 288.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{  96.f / 480.f, 288.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 192.f / 480.f, 288.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 288.f / 480.f, 288.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-	Frame{
-		{ 96.f, 96.f },
-		{ 384.f / 480.f, 288.f / 384.f },
-		{  96.f / 480.f,  96.f / 384.f }
-	},
-};
+const unsigned EXPLOSION_FRAMES = 20;
+
+std::array<Frame, frameNames.size()> frames;
+std::array<Frame, EXPLOSION_FRAMES> expFrames;
 
 constexpr std::array enemyWaves = {
 	EnemyWave{ EnemyType::Eagle,  100.f,  20.f, 5.f, 2 },
@@ -199,6 +55,18 @@ constexpr std::array enemyWaves = {
 
 GameState::GameState()
 {
+	for (unsigned i = 0; i < frames.size(); ++i)
+	{
+		frames[i] = world.atlas.getFrame(frameNames[i]);
+	}
+	for (unsigned i = 0; i < expFrames.size(); ++i)
+	{
+		expFrames[i] = world.atlas.getFrame("explosion_" + std::to_string(i));
+	}
+	world.debris.setFrames(expFrames, world.sprites, glm::vec2(24.f));
+	world.debris.setDrag(1.5f);
+	world.debris.clear();
+
 	world.player.pos = (glm::vec2(640.f, 480.f) - glm::vec2(48.f, 64.f))
 		* glm::vec2(0.5f, 0.8f);
 	world.player.maxBulletCount = 3;
@@ -207,6 +75,12 @@ GameState::GameState()
 	world.nextWave = 0;
 }
 
+bool
+GameState::isOpaque() const
+{
+	return true;
+}
+
 bool
 GameState::update(float dt)
 {
@@ -216,6 +90,7 @@ GameState::update(float dt)
 	updateBullets(dt);
 	updatePlayer(world.player, dt);
 	updateExplosions(dt);
+	world.debris.update(dt);
 	collideBulletsEnemies();
 	return true;
 }
@@ -224,10 +99,11 @@ void
 GameState::updateMap(float dt)
 {
 	// scroll the map
+	const float mapEnd = world.map.getSize().y - 480.f;
 	world.mapPosition += 4.f * dt;
-	if (world.mapPosition >= 480.f * 9.f)
+	if (world.mapPosition >= mapEnd)
 	{
-		world.mapPosition = 480.f * 9.f;
+		world.mapPosition = mapEnd;
 	}
 }
 
@@ -469,26 +345,39 @@ void
 GameState::draw(RenderTarget &target)
 {
 	target.clear(Color::fromRGBA(0, 0, 40));
-        // NOTE: draw the world
-	target.beginFrames(world.textures.get(TextureID::Entities));
+	// NOTE: the map scrolls upwards from its bottom
+	target.setLayer(LAYER_BACKGROUND);
+	target.draw(world.map, world.map.getSize().y - 480.f - world.mapPosition);
+
+        // NOTE: draw the world, explosions included, in one batch
+	mSprites.clear();
 	for (const auto &e : world.enemies)
 	{
-		target.addFrame(frames[e.frameIndex], e.pos);
+		mSprites.push_back(Sprite{ &frames[e.frameIndex], e.pos, Color::White });
 	}
 	for (const auto &b : world.playerBullets)
 	{
-		target.addFrame(frames[b.frameIndex], b.pos);
+		mSprites.push_back(Sprite{ &frames[b.frameIndex], b.pos, Color::White });
 	}
-	target.addFrame(frames[world.player.frameIndex], world.player.pos);
-	target.endFrames();
-
-	// NOTE: Explosions use a different texture
-	target.beginFrames(world.textures.get(TextureID::Explosion));
+	mSprites.push_back(Sprite{
+			&frames[world.player.frameIndex],
+			world.player.pos,
+			Color::White,
+		});
 	for (const auto &e : world.explosions)
 	{
-		target.addFrame(expFrames[e.frameIndex], e.pos);
+		mSprites.push_back(Sprite{ &expFrames[e.frameIndex], e.pos, Color::White });
 	}
+
+	target.setLayer(LAYER_ENTITIES);
+	target.beginFrames(world.sprites);
+	target.addFrames(mSprites);
 	target.endFrames();
+
+	target.setLayer(LAYER_EFFECTS);
+	target.setBlendMode(BlendMode::Additive);
+	target.draw(world.debris);
+	target.setBlendMode(BlendMode::Alpha);
 }
 
 void
@@ -561,6 +450,8 @@ GameState::createExplosion(glm::vec2 pos)
 		pos - glm::vec2(96.f) * 0.5f,
 		0,
 		.03333f);
+	world.debris.emit(pos, 256, 220.f, 0.8f);
+	world.post.shake(6.f, 0.3f);
 }
 
 void
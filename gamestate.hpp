@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "rect.hpp"
 #include "state.hpp"
 #include "world.hpp"
@@ -12,6 +14,7 @@ public:
 	bool update(float dt) override;
 	bool handleEvent(const Event &event) override;
 	void draw(RenderTarget &target) override;
+	bool isOpaque() const override;
 
 private:
 	void updateMap(float dt);
@@ -32,4 +35,7 @@ private:
 
 	void createExplosion(glm::vec2 pos);
 	void updateExplosions(float dt);
+
+private:
+	std::vector<Sprite> mSprites;
 };
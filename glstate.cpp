@@ -0,0 +1,270 @@
+#include <array>
+
+#include <GL/glew.h>
+
+#include "glcheck.hpp"
+#include "glstate.hpp"
+
+namespace
+{
+// NOTE: the state is unknown until the first call
+const unsigned UNKNOWN = -1U;
+const unsigned MAX_TEXTURE_UNITS = 16;
+
+constexpr std::array<unsigned, 2> textureTargets = {
+	GL_TEXTURE_2D,
+	GL_TEXTURE_2D_ARRAY,
+};
+
+constexpr std::array<unsigned, 5> bufferTargets = {
+	GL_ARRAY_BUFFER,
+	GL_ELEMENT_ARRAY_BUFFER,
+	GL_UNIFORM_BUFFER,
+	GL_PIXEL_UNPACK_BUFFER,
+	GL_TRANSFORM_FEEDBACK_BUFFER,
+};
+
+struct State
+{
+	State()
+	{
+		for (auto &unit : textures)
+		{
+			unit.fill(UNKNOWN);
+		}
+		buffers.fill(UNKNOWN);
+	}
+
+	unsigned program = UNKNOWN;
+	unsigned activeTexture = 0;
+	std::array<std::array<unsigned, textureTargets.size()>, MAX_TEXTURE_UNITS> textures;
+	unsigned vao = UNKNOWN;
+	std::array<unsigned, bufferTargets.size()> buffers;
+	unsigned framebuffer = UNKNOWN;
+	unsigned blend = UNKNOWN;
+	unsigned blendSource = UNKNOWN;
+	unsigned blendDestination = UNKNOWN;
+
+	GLState::Counters counters{};
+};
+
+State state;
+
+static inline bool
+update(unsigned &current, unsigned value)
+{
+	if (current == value)
+	{
+		state.counters.elided++;
+		return false;
+	}
+	state.counters.issued++;
+	current = value;
+	return true;
+}
+
+static inline unsigned *
+findTexture(unsigned unit, unsigned target)
+{
+	for (std::size_t i = 0; i < textureTargets.size(); ++i)
+	{
+		if (textureTargets[i] == target && unit < MAX_TEXTURE_UNITS)
+		{
+			return &state.textures[unit][i];
+		}
+	}
+	return nullptr;
+}
+
+static inline unsigned *
+findBuffer(unsigned target)
+{
+	for (std::size_t i = 0; i < bufferTargets.size(); ++i)
+	{
+		if (bufferTargets[i] == target)
+		{
+			return &state.buffers[i];
+		}
+	}
+	return nullptr;
+}
+}
+
+namespace GLState
+{
+void
+useProgram(unsigned program)
+{
+	if (update(state.program, program))
+	{
+		glCheck(glUseProgram(program));
+	}
+}
+
+void
+bindTexture(unsigned target, unsigned texture)
+{
+	auto *current = findTexture(state.activeTexture, target);
+	if (current == nullptr)
+	{
+		state.counters.issued++;
+		glCheck(glBindTexture(target, texture));
+	}
+	else if (update(*current, texture))
+	{
+		glCheck(glBindTexture(target, texture));
+	}
+}
+
+void
+bindTexture(unsigned unit, unsigned target, unsigned texture)
+{
+	auto *current = findTexture(unit, target);
+	if (current && *current == texture)
+	{
+		state.counters.elided++;
+		return;
+	}
+	if (update(state.activeTexture, unit))
+	{
+		glCheck(glActiveTexture(GL_TEXTURE0 + unit));
+	}
+	bindTexture(target, texture);
+}
+
+void
+bindVertexArray(unsigned vao)
+{
+	if (update(state.vao, vao))
+	{
+		glCheck(glBindVertexArray(vao));
+
+		// NOTE: the element buffer binding is part of the VAO
+		*findBuffer(GL_ELEMENT_ARRAY_BUFFER) = UNKNOWN;
+	}
+}
+
+void
+bindBuffer(unsigned target, unsigned buffer)
+{
+	auto *current = findBuffer(target);
+	if (current == nullptr)
+	{
+		state.counters.issued++;
+		glCheck(glBindBuffer(target, buffer));
+	}
+	else if (update(*current, buffer))
+	{
+		glCheck(glBindBuffer(target, buffer));
+	}
+}
+
+void
+bindFramebuffer(unsigned framebuffer)
+{
+	if (update(state.framebuffer, framebuffer))
+	{
+		glCheck(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+	}
+}
+
+void
+enableBlend(bool enable)
+{
+	if (update(state.blend, enable))
+	{
+		if (enable)
+		{
+			glCheck(glEnable(GL_BLEND));
+		}
+		else
+		{
+			glCheck(glDisable(GL_BLEND));
+		}
+	}
+}
+
+void
+blendFunc(unsigned source, unsigned destination)
+{
+	if (state.blendSource == source && state.blendDestination == destination)
+	{
+		state.counters.elided++;
+		return;
+	}
+	state.counters.issued++;
+	state.blendSource = source;
+	state.blendDestination = destination;
+	glCheck(glBlendFunc(source, destination));
+}
+
+void
+forgetProgram(unsigned program)
+{
+	// NOTE: the name may be reused by the next program
+	if (state.program == program)
+	{
+		state.program = UNKNOWN;
+	}
+}
+
+void
+forgetTexture(unsigned texture)
+{
+	// NOTE: deleted textures revert to zero on every unit
+	for (auto &unit : state.textures)
+	{
+		for (auto &current : unit)
+		{
+			if (current == texture)
+			{
+				current = 0;
+			}
+		}
+	}
+}
+
+void
+forgetVertexArray(unsigned vao)
+{
+	if (state.vao == vao)
+	{
+		state.vao = 0;
+		*findBuffer(GL_ELEMENT_ARRAY_BUFFER) = UNKNOWN;
+	}
+}
+
+void
+forgetBuffer(unsigned buffer)
+{
+	for (auto &current : state.buffers)
+	{
+		if (current == buffer)
+		{
+			current = 0;
+		}
+	}
+}
+
+void
+forgetFramebuffer(unsigned framebuffer)
+{
+	// NOTE: deleting the bound framebuffer binds the default one
+	if (state.framebuffer == framebuffer)
+	{
+		state.framebuffer = 0;
+	}
+}
+
+const Counters &
+getCounters()
+{
+	return state.counters;
+}
+
+void
+resetCounters()
+{
+	state.counters = Counters{};
+}
+}
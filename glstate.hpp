@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+ * Cache of the GL bindings to skip the redundant driver calls.
+ *
+ * Every bind must go through these functions, otherwise the cache
+ * gets out of sync with the real GL state.
+ */
+namespace GLState
+{
+struct Counters
+{
+	unsigned issued;
+	unsigned elided;
+};
+
+void useProgram(unsigned program);
+void bindTexture(unsigned target, unsigned texture);
+void bindTexture(unsigned unit, unsigned target, unsigned texture);
+void bindVertexArray(unsigned vao);
+void bindBuffer(unsigned target, unsigned buffer);
+void bindFramebuffer(unsigned framebuffer);
+void enableBlend(bool enable);
+void blendFunc(unsigned source, unsigned destination);
+
+// NOTE: to be called before the objects are deleted
+void forgetProgram(unsigned program);
+void forgetTexture(unsigned texture);
+void forgetVertexArray(unsigned vao);
+void forgetBuffer(unsigned buffer);
+void forgetFramebuffer(unsigned framebuffer);
+
+const Counters &getCounters();
+void resetCounters();
+}
@@ -0,0 +1,122 @@
+#include <cassert>
+
+#include <GL/glew.h>
+
+#include "glcheck.hpp"
+#include "gputimer.hpp"
+
+GpuTimer::GpuTimer()
+	: mFrames()
+	, mMilliseconds()
+	, mCurrent(0)
+	, mOpen(false)
+{
+}
+
+void
+GpuTimer::create(unsigned sections)
+{
+	mMilliseconds.assign(sections, 0.f);
+	mCurrent = 0;
+	mOpen = false;
+}
+
+void
+GpuTimer::destroy()
+{
+	for (auto &frame : mFrames)
+	{
+		if (!frame.queries.empty())
+		{
+			glCheck(glDeleteQueries(frame.queries.size(), frame.queries.data()));
+		}
+		frame.queries.clear();
+		frame.sections.clear();
+		frame.used = 0;
+	}
+}
+
+void
+GpuTimer::beginFrame()
+{
+	stop();
+
+	// NOTE: the oldest frame is the one about to be reused
+	mCurrent = (mCurrent + 1) % FrameLatency;
+	collect(mFrames[mCurrent]);
+}
+
+void
+GpuTimer::mark(unsigned section)
+{
+	assert(section < mMilliseconds.size() && "Section out of range");
+	timestamp(section);
+	mOpen = true;
+}
+
+void
+GpuTimer::stop()
+{
+	if (mOpen)
+	{
+		timestamp(NoSection);
+		mOpen = false;
+	}
+}
+
+float
+GpuTimer::getMilliseconds(unsigned section) const
+{
+	assert(section < mMilliseconds.size() && "Section out of range");
+	return mMilliseconds[section];
+}
+
+void
+GpuTimer::timestamp(unsigned section)
+{
+	auto &frame = mFrames[mCurrent];
+	if (frame.used == frame.queries.size())
+	{
+		unsigned query;
+		glCheck(glGenQueries(1, &query));
+		frame.queries.push_back(query);
+		frame.sections.push_back(NoSection);
+	}
+	frame.sections[frame.used] = section;
+	glCheck(glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP));
+	frame.used++;
+}
+
+void
+GpuTimer::collect(Frame &frame)
+{
+	if (frame.used == 0)
+	{
+		return;
+	}
+
+	// NOTE: the queries complete in order, check only the last one
+	GLint available = 0;
+	glCheck(glGetQueryObjectiv(frame.queries[frame.used - 1],
+	                           GL_QUERY_RESULT_AVAILABLE,
+	                           &available));
+	if (available)
+	{
+		mMilliseconds.assign(mMilliseconds.size(), 0.f);
+		GLuint64 previous = 0;
+		for (unsigned i = 0; i < frame.used; ++i)
+		{
+			GLuint64 time;
+			glCheck(glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &time));
+
+			// each timestamp closes the interval opened by the
+			// previous one
+			if (i > 0 && frame.sections[i - 1] != NoSection)
+			{
+				mMilliseconds[frame.sections[i - 1]] += (time - previous) * 1e-6f;
+			}
+			previous = time;
+		}
+	}
+	frame.used = 0;
+}
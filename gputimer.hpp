@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+/**
+ * GPU time spent in sections of the frame, measured with timestamp
+ * queries.
+ *
+ * The queries of a frame are read FrameLatency frames later so that
+ * the CPU never waits for the GPU, the results of a frame which is
+ * still not done by then are dropped.
+ */
+class GpuTimer
+{
+public:
+	static constexpr unsigned FrameLatency = 3;
+
+public:
+	GpuTimer();
+
+	GpuTimer(const GpuTimer &) = delete;
+	GpuTimer& operator=(const GpuTimer &) = delete;
+	GpuTimer(GpuTimer &&) noexcept = delete;
+	GpuTimer& operator=(GpuTimer &&) noexcept = delete;
+
+	void create(unsigned sections);
+	void destroy();
+
+	/**
+	 * Collect the results of an old frame and start a new one.
+	 */
+	void beginFrame();
+
+	/**
+	 * Close the current interval and open one for @section.
+	 */
+	void mark(unsigned section);
+
+	/**
+	 * Close the current interval.
+	 */
+	void stop();
+
+	/**
+	 * Get the milliseconds spent in @section by the last frame
+	 * which has been read back.
+	 */
+	float getMilliseconds(unsigned section) const;
+
+private:
+	static constexpr unsigned NoSection = -1U;
+
+	struct Frame
+	{
+		std::vector<unsigned> queries;
+		std::vector<unsigned> sections;
+		unsigned used = 0;
+	};
+
+	void timestamp(unsigned section);
+	void collect(Frame &frame);
+
+private:
+	std::array<Frame, FrameLatency> mFrames;
+	std::vector<float> mMilliseconds;
+	unsigned mCurrent;
+	bool     mOpen;
+};
@@ -15,11 +15,38 @@ constexpr std::array Options =  {
 
 MenuState::MenuState()
 	: mRectangle()
+	, mBackground()
+	, mBackgroundReady(false)
+	, mOptions()
 	, mOptionIndex(Play)
 {
 	glm::vec2 windowSize = glm::vec2(640.f, 480.f);
 	mRectangle.setSize(windowSize);
 	mRectangle.setColor(Color::fromRGBA(40, 40, 40, 100));
+
+	if (!mBackground.create(windowSize.x, windowSize.y))
+	{
+		throw std::runtime_error("MenuState - Unable to create the background");
+	}
+
+	auto &font = world.fonts.get(FontID::Title);
+	glm::vec2 pos(300.f, 240.f);
+	for (unsigned i = 0; i < OptionCount; ++i)
+	{
+		mOptions[i].setFont(font);
+		mOptions[i].setString(Options[i]);
+		mOptions[i].setPosition(pos);
+		pos.y += 80.f;
+	}
+}
+
+MenuState::~MenuState()
+{
+	for (auto &option : mOptions)
+	{
+		option.destroy();
+	}
+	mBackground.destroy();
 }
 
 bool
@@ -67,19 +94,38 @@ MenuState::handleEvent(const Event &event)
 void
 MenuState::draw(RenderTarget &target)
 {
-	target.clear();
-	auto &background = world.textures.get(TextureID::TitleScreen);
-	target.draw(background, glm::vec2(0.f));
-	target.draw(mRectangle);
+	// NOTE: the background and its overlay never change
+	if (!mBackgroundReady)
+	{
+		auto &background = world.textures.get(TextureID::TitleScreen);
+		target.setRenderTexture(&mBackground);
+		target.clear();
+		target.setLayer(LAYER_BACKGROUND);
+		target.draw(background, glm::vec2(0.f));
+		target.setLayer(LAYER_OVERLAY);
+		target.draw(mRectangle);
+		target.setRenderTexture(nullptr);
 
-	auto &font = world.fonts.get(FontID::Title);
-	glm::vec2 pos(300.f, 240.f);
-	unsigned i = 0;
-	for (const auto &option: Options)
+		// NOTE: draw it again once the image has been loaded
+		mBackgroundReady = world.textures.get(TextureID::TitleScreen).isReady();
+	}
+
+	target.setLayer(LAYER_BACKGROUND);
+	target.setBlendMode(BlendMode::None);
+	target.draw(mBackground.getTexture(), glm::vec2(0.f));
+	target.setBlendMode(BlendMode::Alpha);
+
+	// NOTE: the options are laid out again only when selected
+	target.setLayer(LAYER_TEXT);
+	for (unsigned i = 0; i < OptionCount; ++i)
 	{
-		Color color = i == mOptionIndex ? Color::Red : Color::White;
-		target.draw(option, pos, font, color);
-		pos.y += 80.f;
-		i++;
+		mOptions[i].setColor(i == mOptionIndex ? Color::Red : Color::White);
+		target.draw(mOptions[i]);
 	}
 }
+
+bool
+MenuState::isOpaque() const
+{
+	return true;
+}
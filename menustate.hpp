@@ -4,7 +4,9 @@
 #include <memory>
 
 #include "rectangleshape.hpp"
+#include "rendertexture.hpp"
 #include "state.hpp"
+#include "text.hpp"
 
 class MenuState: public State
 {
@@ -17,12 +19,17 @@ public:
 	};
 public:
 	MenuState();
+	~MenuState() override;
 
 	bool update(float dt) override;
 	bool handleEvent(const Event &event) override;
 	void draw(RenderTarget &target) override;
+	bool isOpaque() const override;
 
 private:
 	RectangleShape mRectangle;
+	RenderTexture  mBackground;
+	bool           mBackgroundReady;
+	std::array<Text, OptionCount> mOptions;
 	unsigned       mOptionIndex;
 };
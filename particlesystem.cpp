@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include "frame.hpp"
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "particlesystem.hpp"
+#include "texturearray.hpp"
+
+ParticleSystem::ParticleSystem()
+	: mPending()
+	, mFrames()
+	, mRandom(std::random_device{}())
+	, mUpdateShader()
+	, mSize(0.f)
+	, mLayer(0.f)
+	, mDrag(0.f)
+	, mTime(0.f)
+	, mTexture(0)
+	, mCapacity(0)
+	, mUsed(0)
+	, mHead(0)
+	, mSource(0)
+	, mBuffers{}
+	, mUpdateVAOs{}
+	, mDrawVAOs{}
+{
+}
+
+bool
+ParticleSystem::create(unsigned capacity)
+{
+	mCapacity = capacity;
+	mUsed = mHead = mSource = 0;
+	mTime = 0.f;
+
+	mUpdateShader.create();
+	mUpdateShader.attachFile(ShaderType::Vertex, "assets/shaders/particle_update.vert");
+	mUpdateShader.setFeedbackVaryings({
+			"OutPosition",
+			"OutVelocity",
+			"OutSpawn",
+			"OutLife",
+		});
+	mUpdateShader.link();
+
+	// NOTE: a zero life marks the particle as dead
+	const std::vector<Particle> particles(capacity, Particle{});
+	glCheck(glGenBuffers(2, mBuffers));
+	glCheck(glGenVertexArrays(2, mUpdateVAOs));
+	glCheck(glGenVertexArrays(2, mDrawVAOs));
+	for (unsigned i = 0; i < 2; ++i)
+	{
+		GLState::bindBuffer(GL_ARRAY_BUFFER, mBuffers[i]);
+		glCheck(glBufferData(GL_ARRAY_BUFFER,
+		                     particles.size() * sizeof(Particle),
+		                     particles.data(),
+		                     GL_DYNAMIC_COPY));
+
+		// one vertex for each particle in the update pass
+		GLState::bindVertexArray(mUpdateVAOs[i]);
+		glCheck(glEnableVertexAttribArray(0));
+		glCheck(glVertexAttribPointer(
+			        0, 2, GL_FLOAT, GL_FALSE, sizeof(Particle),
+			        reinterpret_cast<GLvoid*>(offsetof(Particle, pos))));
+		glCheck(glEnableVertexAttribArray(1));
+		glCheck(glVertexAttribPointer(
+			        1, 2, GL_FLOAT, GL_FALSE, sizeof(Particle),
+			        reinterpret_cast<GLvoid*>(offsetof(Particle, vel))));
+		glCheck(glEnableVertexAttribArray(2));
+		glCheck(glVertexAttribPointer(
+			        2, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
+			        reinterpret_cast<GLvoid*>(offsetof(Particle, spawn))));
+		glCheck(glEnableVertexAttribArray(3));
+		glCheck(glVertexAttribPointer(
+			        3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
+			        reinterpret_cast<GLvoid*>(offsetof(Particle, life))));
+
+		// one instanced quad for each particle when drawing
+		GLState::bindVertexArray(mDrawVAOs[i]);
+		glCheck(glEnableVertexAttribArray(0));
+		glCheck(glVertexAttribPointer(
+			        0, 2, GL_FLOAT, GL_FALSE, sizeof(Particle),
+			        reinterpret_cast<GLvoid*>(offsetof(Particle, pos))));
+		glCheck(glVertexAttribDivisor(0, 1));
+		glCheck(glEnableVertexAttribArray(2));
+		glCheck(glVertexAttribPointer(
+			        2, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
+			        reinterpret_cast<GLvoid*>(offsetof(Particle, spawn))));
+		glCheck(glVertexAttribDivisor(2, 1));
+		glCheck(glEnableVertexAttribArray(3));
+		glCheck(glVertexAttribPointer(
+			        3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
+			        reinterpret_cast<GLvoid*>(offsetof(Particle, life))));
+		glCheck(glVertexAttribDivisor(3, 1));
+	}
+	return true;
+}
+
+void
+ParticleSystem::destroy()
+{
+	if (mBuffers[0])
+	{
+		for (unsigned i = 0; i < 2; ++i)
+		{
+			GLState::forgetVertexArray(mUpdateVAOs[i]);
+			GLState::forgetVertexArray(mDrawVAOs[i]);
+			GLState::forgetBuffer(mBuffers[i]);
+		}
+		glCheck(glDeleteVertexArrays(2, mUpdateVAOs));
+		glCheck(glDeleteVertexArrays(2, mDrawVAOs));
+		glCheck(glDeleteBuffers(2, mBuffers));
+		std::fill(std::begin(mBuffers), std::end(mBuffers), 0);
+		mUpdateShader.destroy();
+	}
+	mPending.clear();
+	mCapacity = mUsed = mHead = 0;
+}
+
+void
+ParticleSystem::setFrames(std::span<const Frame> frames, const TextureArray &texture,
+                          glm::vec2 size)
+{
+	mFrames.clear();
+	for (const auto &frame : frames.first(std::min<std::size_t>(frames.size(), MaxFrames)))
+	{
+		const auto scale = texture.getLayerScale(frame.layer);
+		mFrames.emplace_back(frame.uvPos * scale, frame.uvSize * scale);
+	}
+	mLayer = frames.empty() ? 0.f : frames[0].layer;
+	mTexture = texture.getNativeHandle();
+	mSize = size;
+}
+
+void
+ParticleSystem::setDrag(float drag)
+{
+	mDrag = drag;
+}
+
+void
+ParticleSystem::emit(glm::vec2 pos, unsigned count, float speed, float life)
+{
+	std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const float a = angle(mRandom);
+		const float v = speed * std::sqrt(unit(mRandom));
+		mPending.push_back(Particle{
+				pos,
+				glm::vec2(std::cos(a), std::sin(a)) * v,
+				mTime,
+				life * (0.5f + 0.5f * unit(mRandom)),
+			});
+	}
+}
+
+void
+ParticleSystem::update(float dt)
+{
+	mTime += dt;
+	upload();
+	if (mUsed == 0)
+	{
+		return;
+	}
+
+	// NOTE: the update pass only runs the vertex shader, the
+	// outputs are captured in the other buffer
+	const unsigned target = mSource ^ 1;
+	mUpdateShader.use();
+	mUpdateShader.getUniform("DeltaTime").setFloat(dt);
+	mUpdateShader.getUniform("Drag").setFloat(mDrag);
+	GLState::bindVertexArray(mUpdateVAOs[mSource]);
+	GLState::bindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, mBuffers[target]);
+	glCheck(glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mBuffers[target]));
+	glCheck(glEnable(GL_RASTERIZER_DISCARD));
+	glCheck(glBeginTransformFeedback(GL_POINTS));
+	glCheck(glDrawArrays(GL_POINTS, 0, mUsed));
+	glCheck(glEndTransformFeedback());
+	glCheck(glDisable(GL_RASTERIZER_DISCARD));
+	mSource = target;
+}
+
+void
+ParticleSystem::clear()
+{
+	mPending.clear();
+	mUsed = mHead = 0;
+}
+
+void
+ParticleSystem::upload()
+{
+	if (mPending.empty() || mCapacity == 0)
+	{
+		return;
+	}
+
+	// only the newest particles survive when too many are spawned
+	std::span<const Particle> pending(mPending);
+	if (pending.size() > mCapacity)
+	{
+		pending = pending.last(mCapacity);
+	}
+
+	// the new particles overwrite the oldest ones in the ring
+	GLState::bindBuffer(GL_ARRAY_BUFFER, mBuffers[mSource]);
+	while (!pending.empty())
+	{
+		const auto count = std::min<std::size_t>(pending.size(), mCapacity - mHead);
+		glCheck(glBufferSubData(GL_ARRAY_BUFFER,
+		                        mHead * sizeof(Particle),
+		                        count * sizeof(Particle),
+		                        pending.data()));
+		pending = pending.subspan(count);
+		mHead = (mHead + count) % mCapacity;
+		mUsed = std::max(mUsed, mHead ? mHead : mCapacity);
+	}
+	mPending.clear();
+}
+
+float
+ParticleSystem::getTime() const
+{
+	return mTime;
+}
+
+unsigned
+ParticleSystem::getTexture() const
+{
+	return mTexture;
+}
+
+unsigned
+ParticleSystem::getVertexArray() const
+{
+	return mDrawVAOs[mSource];
+}
+
+unsigned
+ParticleSystem::getParticleCount() const
+{
+	return mUsed;
+}
+
+std::span<const glm::vec4>
+ParticleSystem::getFrames() const
+{
+	return mFrames;
+}
+
+glm::vec2
+ParticleSystem::getSize() const
+{
+	return mSize;
+}
+
+float
+ParticleSystem::getLayer() const
+{
+	return mLayer;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <random>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "shader.hpp"
+
+class TextureArray;
+struct Frame;
+
+/**
+ * Particles simulated on the GPU.
+ *
+ * The particles live in two buffers used in turn as the source and
+ * the destination of a transform feedback pass; the CPU only writes
+ * the particles spawned by emit(), the rest of their life runs in
+ * the shaders. The frame of the flipbook is picked from the age of
+ * the particle when it is drawn, dead particles are not rasterized.
+ * New particles overwrite the oldest ones when the buffer is full.
+ */
+class ParticleSystem
+{
+public:
+	static constexpr unsigned MaxFrames = 32;
+
+	struct Particle
+	{
+		glm::vec2 pos;
+		glm::vec2 vel;
+		float spawn;
+		float life;
+	};
+
+public:
+	ParticleSystem();
+
+	ParticleSystem(const ParticleSystem &) = delete;
+	ParticleSystem& operator=(const ParticleSystem &) = delete;
+	ParticleSystem(ParticleSystem &&) noexcept = delete;
+	ParticleSystem& operator=(ParticleSystem &&) noexcept = delete;
+
+	bool create(unsigned capacity);
+	void destroy();
+
+	/**
+	 * Play the @frames of the @texture during the life of the
+	 * particles, each one drawn @size pixels wide.
+	 */
+	void setFrames(std::span<const Frame> frames, const TextureArray &texture,
+	               glm::vec2 size);
+
+	/**
+	 * Set the fraction of the velocity lost in a second.
+	 */
+	void setDrag(float drag);
+
+	/**
+	 * Spawn @count particles at @pos moving in random directions
+	 * at up to @speed pixels per second for @life seconds.
+	 */
+	void emit(glm::vec2 pos, unsigned count, float speed, float life);
+
+	/**
+	 * Upload the new particles and advance all of them by @dt.
+	 */
+	void update(float dt);
+
+	/**
+	 * Drop all the particles.
+	 */
+	void clear();
+
+	float getTime() const;
+	unsigned getTexture() const;
+	unsigned getVertexArray() const;
+	unsigned getParticleCount() const;
+
+	std::span<const glm::vec4> getFrames() const;
+	glm::vec2 getSize() const;
+	float getLayer() const;
+
+private:
+	void upload();
+
+private:
+	std::vector<Particle> mPending;
+	std::vector<glm::vec4> mFrames;
+	std::mt19937 mRandom;
+	Shader    mUpdateShader;
+	glm::vec2 mSize;
+	float     mLayer;
+	float     mDrag;
+	float     mTime;
+	unsigned  mTexture;
+	unsigned  mCapacity;
+	unsigned  mUsed;
+	unsigned  mHead;
+	unsigned  mSource;
+	unsigned  mBuffers[2];
+	unsigned  mUpdateVAOs[2];
+	unsigned  mDrawVAOs[2];
+};
@@ -7,9 +7,32 @@
 
 PauseState::PauseState()
 	: mBackground()
+	, mSnapshot()
+	, mTitle()
+	, mHint()
+	, mSnapshotReady(false)
 {
 	mBackground.setSize(glm::vec2(640.f, 480.f));
 	mBackground.setColor(Color::fromRGBA(0, 0, 0, 150));
+
+	if (!mSnapshot.create(640, 480))
+	{
+		throw std::runtime_error("PauseState - Unable to create the snapshot");
+	}
+
+	mTitle.setFont(world.fonts.get(FontID::Title));
+	mTitle.setString("Game Paused");
+	mTitle.setPosition(glm::vec2(200.f, 200.f));
+	mHint.setFont(world.fonts.get(FontID::Body));
+	mHint.setString("Press Backspace to return to the main menu");
+	mHint.setPosition(glm::vec2(70.f, 280.f));
+}
+
+PauseState::~PauseState()
+{
+	mTitle.destroy();
+	mHint.destroy();
+	mSnapshot.destroy();
 }
 
 bool
@@ -42,11 +65,28 @@ PauseState::handleEvent(const Event &event)
 void
 PauseState::draw(RenderTarget &target)
 {
-	target.draw(mBackground);
-	target.draw("Game Paused", {200.f, 200.f},
-	            world.fonts.get(FontID::Title),
-	            Color::White);
-	target.draw("Press Backspace to return to the main menu", {70.f, 280.f },
-	            world.fonts.get(FontID::Body),
-	            Color::White);
+	// NOTE: the game is frozen, draw it only once
+	if (!mSnapshotReady)
+	{
+		target.setRenderTexture(&mSnapshot);
+		world.states.drawBelow(*this, target);
+		target.setLayer(LAYER_OVERLAY);
+		target.draw(mBackground);
+		target.setRenderTexture(nullptr);
+		mSnapshotReady = true;
+	}
+
+	target.setLayer(LAYER_BACKGROUND);
+	target.setBlendMode(BlendMode::None);
+	target.draw(mSnapshot.getTexture(), glm::vec2(0.f));
+	target.setBlendMode(BlendMode::Alpha);
+	target.setLayer(LAYER_TEXT);
+	target.draw(mTitle);
+	target.draw(mHint);
+}
+
+bool
+PauseState::isOpaque() const
+{
+	return true;
 }
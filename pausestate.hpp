@@ -1,17 +1,25 @@
 #pragma once
 
 #include "rectangleshape.hpp"
+#include "rendertexture.hpp"
 #include "state.hpp"
+#include "text.hpp"
 
 class PauseState: public State
 {
 public:
 	PauseState();
+	~PauseState() override;
 
 	bool update(float dt) override;
 	bool handleEvent(const Event &event) override;
 	void draw(RenderTarget &target) override;
+	bool isOpaque() const override;
 
 private:
 	RectangleShape mBackground;
+	RenderTexture  mSnapshot;
+	Text           mTitle;
+	Text           mHint;
+	bool           mSnapshotReady;
 };
@@ -0,0 +1,264 @@
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "postprocessor.hpp"
+#include "rendertarget.hpp"
+
+namespace
+{
+const float BLOOM_THRESHOLD = 0.7f;
+const float BLOOM_INTENSITY = 1.2f;
+const float GRADE_SATURATION = 1.15f;
+const float GRADE_CONTRAST = 1.1f;
+const glm::vec3 GRADE_TINT(1.05f, 1.f, 0.95f);
+
+static void
+createShader(Shader &shader, const char *fragment)
+{
+	shader.create();
+	shader.attachFile(ShaderType::Vertex, "assets/shaders/post.vert");
+	shader.attachFile(ShaderType::Fragment, fragment);
+	shader.link();
+	shader.use();
+	shader.getUniform("Texture").setInteger(0);
+}
+}
+
+PostProcessor::PostProcessor()
+	: mEnabled{}
+	, mPingPong()
+	, mHalf()
+	, mScene()
+	, mGpuTimer()
+	, mRandom(std::random_device{}())
+	, mSize(0)
+	, mShakeAmplitude(0.f)
+	, mShakeDuration(0.f)
+	, mShakeTime(0.f)
+	, mActive(false)
+	, mVAO(0)
+{
+}
+
+bool
+PostProcessor::create(unsigned width, unsigned height)
+{
+	createShader(mBrightShader, "assets/shaders/bright.frag");
+	createShader(mBlurShader, "assets/shaders/blur.frag");
+	createShader(mBloomShader, "assets/shaders/bloom.frag");
+	mBloomShader.getUniform("Bloom").setInteger(1);
+	createShader(mShakeShader, "assets/shaders/shake.frag");
+	createShader(mGradeShader, "assets/shaders/grade.frag");
+	createShader(mCrtShader, "assets/shaders/crt.frag");
+
+	// NOTE: the full screen triangle is built from the vertex index
+	// but the core profile still needs a VAO
+	glCheck(glGenVertexArrays(1, &mVAO));
+	mGpuTimer.create(static_cast<unsigned>(PostPass::Count));
+	return resize(width, height);
+}
+
+void
+PostProcessor::destroy()
+{
+	if (mVAO)
+	{
+		GLState::forgetVertexArray(mVAO);
+		glCheck(glDeleteVertexArrays(1, &mVAO));
+		mVAO = 0;
+	}
+	for (auto shader : { &mBrightShader, &mBlurShader, &mBloomShader,
+	                     &mShakeShader, &mGradeShader, &mCrtShader })
+	{
+		shader->destroy();
+	}
+	for (auto &texture : mPingPong)
+	{
+		texture.destroy();
+	}
+	for (auto &texture : mHalf)
+	{
+		texture.destroy();
+	}
+	mScene.destroy();
+	mGpuTimer.destroy();
+}
+
+bool
+PostProcessor::resize(unsigned width, unsigned height)
+{
+	// NOTE: a minimized window has no size, keep the old buffers
+	if (width == 0 || height == 0)
+	{
+		return true;
+	}
+	mSize = glm::ivec2(width, height);
+	const unsigned halfWidth = std::max(width / 2, 1U);
+	const unsigned halfHeight = std::max(height / 2, 1U);
+	return mScene.create(width, height, true)
+		&& mPingPong[0].create(width, height, true)
+		&& mPingPong[1].create(width, height, true)
+		&& mHalf[0].create(halfWidth, halfHeight, true)
+		&& mHalf[1].create(halfWidth, halfHeight, true);
+}
+
+void
+PostProcessor::setEnabled(PostPass pass, bool enabled)
+{
+	mEnabled[static_cast<unsigned>(pass)] = enabled;
+}
+
+bool
+PostProcessor::isEnabled(PostPass pass) const
+{
+	return mEnabled[static_cast<unsigned>(pass)];
+}
+
+void
+PostProcessor::shake(float amplitude, float duration)
+{
+	if (amplitude >= mShakeAmplitude * (1.f - mShakeTime / std::max(mShakeDuration, 1e-6f)))
+	{
+		mShakeAmplitude = amplitude;
+		mShakeDuration = duration;
+		mShakeTime = 0.f;
+	}
+}
+
+void
+PostProcessor::update(float dt)
+{
+	mShakeTime = std::min(mShakeTime + dt, mShakeDuration);
+}
+
+void
+PostProcessor::begin(RenderTarget &target)
+{
+	// NOTE: without passes the scene goes straight to the window
+	mActive = std::find(mEnabled.begin(), mEnabled.end(), true) != mEnabled.end();
+	mGpuTimer.beginFrame();
+	if (mActive)
+	{
+		target.setWindowTexture(&mScene);
+	}
+}
+
+void
+PostProcessor::end(RenderTarget &target)
+{
+	if (!mActive)
+	{
+		return;
+	}
+	target.setWindowTexture(nullptr);
+
+	// the shake is skipped once it has faded out
+	const float fade = mShakeDuration > 0.f ? 1.f - mShakeTime / mShakeDuration : 0.f;
+	const bool shaking = isEnabled(PostPass::Shake) && fade > 0.f;
+
+	// the last pass writes to the window
+	PostPass last = PostPass::Count;
+	for (unsigned i = 0; i < mEnabled.size(); ++i)
+	{
+		const auto pass = static_cast<PostPass>(i);
+		if (mEnabled[i] && (pass != PostPass::Shake || shaking))
+		{
+			last = pass;
+		}
+	}
+
+	GLState::enableBlend(false);
+	GLState::bindVertexArray(mVAO);
+	unsigned source = mScene.getTexture().getNativeHandle();
+	unsigned next = 0;
+	const auto output = [&](PostPass pass) -> RenderTexture * {
+		return pass == last ? nullptr : &mPingPong[next];
+	};
+	const auto advance = [&]() {
+		source = mPingPong[next].getTexture().getNativeHandle();
+		next ^= 1;
+	};
+
+	if (last == PostPass::Count)
+	{
+		// NOTE: all the enabled passes are idle, copy the scene
+		mShakeShader.use();
+		mShakeShader.getUniform("Offset").setVector2f(glm::vec2(0.f));
+		draw(mShakeShader, source, nullptr);
+		return;
+	}
+
+	if (isEnabled(PostPass::Bloom))
+	{
+		mGpuTimer.mark(static_cast<unsigned>(PostPass::Bloom));
+		const glm::vec2 texel = glm::vec2(1.f) / glm::vec2(mHalf[0].getSize());
+
+		mBrightShader.use();
+		mBrightShader.getUniform("Threshold").setFloat(BLOOM_THRESHOLD);
+		draw(mBrightShader, source, &mHalf[0]);
+
+		mBlurShader.use();
+		mBlurShader.getUniform("Direction").setVector2f(glm::vec2(texel.x, 0.f));
+		draw(mBlurShader, mHalf[0].getTexture().getNativeHandle(), &mHalf[1]);
+		mBlurShader.getUniform("Direction").setVector2f(glm::vec2(0.f, texel.y));
+		draw(mBlurShader, mHalf[1].getTexture().getNativeHandle(), &mHalf[0]);
+
+		mBloomShader.use();
+		mBloomShader.getUniform("Intensity").setFloat(BLOOM_INTENSITY);
+		GLState::bindTexture(1, GL_TEXTURE_2D, mHalf[0].getTexture().getNativeHandle());
+		draw(mBloomShader, source, output(PostPass::Bloom));
+		advance();
+	}
+	if (shaking)
+	{
+		mGpuTimer.mark(static_cast<unsigned>(PostPass::Shake));
+		std::uniform_real_distribution<float> offset(-1.f, 1.f);
+		const glm::vec2 pixels = glm::vec2(offset(mRandom), offset(mRandom))
+			* mShakeAmplitude * fade;
+
+		mShakeShader.use();
+		mShakeShader.getUniform("Offset").setVector2f(pixels / glm::vec2(mSize));
+		draw(mShakeShader, source, output(PostPass::Shake));
+		advance();
+	}
+	if (isEnabled(PostPass::Grade))
+	{
+		mGpuTimer.mark(static_cast<unsigned>(PostPass::Grade));
+		mGradeShader.use();
+		mGradeShader.getUniform("Saturation").setFloat(GRADE_SATURATION);
+		mGradeShader.getUniform("Contrast").setFloat(GRADE_CONTRAST);
+		mGradeShader.getUniform("Tint").setVector3f(GRADE_TINT);
+		draw(mGradeShader, source, output(PostPass::Grade));
+		advance();
+	}
+	if (isEnabled(PostPass::Crt))
+	{
+		mGpuTimer.mark(static_cast<unsigned>(PostPass::Crt));
+		mCrtShader.use();
+		mCrtShader.getUniform("Resolution").setVector2f(glm::vec2(mSize));
+		draw(mCrtShader, source, output(PostPass::Crt));
+		advance();
+	}
+	mGpuTimer.stop();
+}
+
+float
+PostProcessor::getGpuTime(PostPass pass) const
+{
+	return mGpuTimer.getMilliseconds(static_cast<unsigned>(pass));
+}
+
+void
+PostProcessor::draw(const Shader &shader, unsigned texture, RenderTexture *target)
+{
+	// NOTE: only the window needs the rows flipped
+	shader.getUniform("FlipY").setFloat(target ? 0.f : 1.f);
+	const auto size = target ? target->getSize() : mSize;
+	GLState::bindFramebuffer(target ? target->getNativeHandle() : 0);
+	glCheck(glViewport(0, 0, size.x, size.y));
+	GLState::bindTexture(0, GL_TEXTURE_2D, texture);
+	glCheck(glDrawArrays(GL_TRIANGLES, 0, 3));
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <random>
+
+#include <glm/glm.hpp>
+
+#include "gputimer.hpp"
+#include "rendertexture.hpp"
+#include "shader.hpp"
+
+class RenderTarget;
+
+enum class PostPass
+{
+	Bloom,
+	Shake,
+	Grade,
+	Crt,
+	Count,
+};
+
+/**
+ * Chain of full screen passes applied to the window.
+ *
+ * begin() redirects the window drawing of a RenderTarget into an
+ * offscreen scene, end() runs the enabled passes ping-ponging
+ * between two framebuffers and writes the last one to the window.
+ * The bloom is blurred at half resolution. Every pass is timed on
+ * the GPU; when no pass is enabled, as after create(), the scene
+ * is drawn directly to the window.
+ */
+class PostProcessor
+{
+public:
+	PostProcessor();
+
+	PostProcessor(const PostProcessor &) = delete;
+	PostProcessor& operator=(const PostProcessor &) = delete;
+	PostProcessor(PostProcessor &&) noexcept = delete;
+	PostProcessor& operator=(PostProcessor &&) noexcept = delete;
+
+	bool create(unsigned width, unsigned height);
+	void destroy();
+
+	/**
+	 * Resize the framebuffers to the new size of the window.
+	 */
+	bool resize(unsigned width, unsigned height);
+
+	void setEnabled(PostPass pass, bool enabled);
+	bool isEnabled(PostPass pass) const;
+
+	/**
+	 * Shake the screen by up to @amplitude pixels, fading out in
+	 * @duration seconds.
+	 */
+	void shake(float amplitude, float duration);
+	void update(float dt);
+
+	void begin(RenderTarget &target);
+	void end(RenderTarget &target);
+
+	/**
+	 * Get the GPU milliseconds spent in the @pass a few frames ago.
+	 */
+	float getGpuTime(PostPass pass) const;
+
+private:
+	void draw(const Shader &shader, unsigned texture, RenderTexture *target);
+
+private:
+	std::array<bool, static_cast<unsigned>(PostPass::Count)> mEnabled;
+	std::array<RenderTexture, 2> mPingPong;
+	std::array<RenderTexture, 2> mHalf;
+	RenderTexture mScene;
+	GpuTimer      mGpuTimer;
+	std::mt19937  mRandom;
+
+	Shader mBrightShader;
+	Shader mBlurShader;
+	Shader mBloomShader;
+	Shader mShakeShader;
+	Shader mGradeShader;
+	Shader mCrtShader;
+
+	glm::ivec2 mSize;
+	float      mShakeAmplitude;
+	float      mShakeDuration;
+	float      mShakeTime;
+	bool       mActive;
+	unsigned   mVAO;
+};
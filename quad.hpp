@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/**
+ * Corners of a quad in the order of its vertices and the indices of
+ * its two triangles, every batch of quads is laid out this way.
+ */
+namespace Quad
+{
+inline const std::uint16_t indices[] = { 0, 1, 2, 1, 3, 2 };
+inline const glm::vec2 units[] = {
+	{ 0.f, 0.f },
+	{ 0.f, 1.f },
+	{ 1.f, 0.f },
+	{ 1.f, 1.f },
+};
+}
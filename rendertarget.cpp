@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <iterator>
 #include <cassert>
 
 #include <GL/glew.h>
@@ -6,27 +9,146 @@
 
 #include "color.hpp"
 #include "font.hpp"
+#include "particlesystem.hpp"
+#include "quad.hpp"
 #include "rectangleshape.hpp"
+#include "rendertexture.hpp"
+#include "text.hpp"
+#include "tilemap.hpp"
 #include "glcheck.hpp"
+#include "glstate.hpp"
 #include "rendertarget.hpp"
 #include "window.hpp"
 #include "world.hpp"
 
 namespace
 {
-static const std::uint16_t indices[] = { 0, 1, 2, 1, 3, 2 };
-static const glm::vec2 units[] = {
-	{ 0.f, 0.f },
-	{ 0.f, 1.f },
-	{ 1.f, 0.f },
-	{ 1.f, 1.f },
+// NOTE: vertex indices are 16 bits wide
+const unsigned MAX_BATCH_QUADS = (UINT16_MAX + 1) / 4;
+const std::size_t STREAM_REGION_SIZE = 8 << 20;
+const std::size_t MIN_MAPPED_SIZE = 256 << 10;
+const unsigned TEXT_BUFFER_QUADS = 4096;
+
+// NOTE: 32 bits indices are limited by the quads of the smallest
+// vertex (16 bytes) which fit in a region
+const unsigned MAX_WIDE_BATCH_QUADS = STREAM_REGION_SIZE / (4 * 16);
+const unsigned GLOBALS_BINDING = 0;
+
+// NOTE: drawn in place of the textures which are still loading
+const Color PLACEHOLDER_COLOR = Color::fromRGBA(32, 32, 32);
+
+// NOTE: below this count the threads cost more than they save
+const std::size_t PARALLEL_MIN_SPRITES = 16384;
+const std::size_t PARALLEL_GRAIN = 4096;
+
+// NOTE: layout of the sort key, from the most significant bit:
+// layer (8), blend mode (4), program (4), texture (24), sequence (24)
+const unsigned LAYER_SHIFT = 56;
+const unsigned BLEND_SHIFT = 52;
+const unsigned PROGRAM_SHIFT = 48;
+const unsigned TEXTURE_SHIFT = 24;
+const std::uint64_t FIELD_MASK = 0xF;
+const std::uint64_t TEXTURE_MASK = 0xFFFFFF;
+const std::uint64_t SEQUENCE_MASK = 0xFFFFFF;
+
+static inline std::size_t
+alignUp(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static inline bool
+sameState(std::uint64_t a, std::uint64_t b)
+{
+	return (a >> TEXTURE_SHIFT) == (b >> TEXTURE_SHIFT);
+}
+
+template <typename Index>
+static unsigned
+createQuadIndices(unsigned quads)
+{
+	std::vector<Index> quadIndices;
+	quadIndices.reserve(quads * std::size(Quad::indices));
+	for (unsigned quad = 0; quad < quads; ++quad)
+	{
+		for (auto i : Quad::indices)
+		{
+			quadIndices.push_back(quad * 4 + i);
+		}
+	}
+
+	// NOTE: upload through GL_ARRAY_BUFFER, the element array
+	// binding belongs to the bound VAO
+	unsigned buffer;
+	glCheck(glGenBuffers(1, &buffer));
+	GLState::bindBuffer(GL_ARRAY_BUFFER, buffer);
+	glCheck(glBufferData(GL_ARRAY_BUFFER,
+	                     quadIndices.size() * sizeof(quadIndices[0]),
+	                     quadIndices.data(),
+	                     GL_STATIC_DRAW));
+	return buffer;
+}
+
+template <typename Vertex>
+static inline void
+writeQuad(Vertex *v, glm::vec2 pos, glm::vec2 size, glm::vec2 uvPos, glm::vec2 uvSize)
+{
+	for (auto unit : Quad::units)
+	{
+		v->pos = unit * size + pos;
+		v->uv = unit * uvSize + uvPos;
+		++v;
+	}
+}
+
+struct Affine
+{
+	glm::vec2 t;
+	glm::vec2 ex;
+	glm::vec2 ey;
 };
+
+static inline Affine
+getAffine(const TransformedSprite &sprite)
+{
+	// NOTE: the transform of Transformable folded in a 2x3 affine,
+	// the corners are the translation plus the scaled edges
+	const float angle = glm::radians(sprite.rotation);
+	const float c = std::cos(angle);
+	const float s = std::sin(angle);
+	const glm::vec2 size = sprite.frame->size * sprite.scale;
+	return Affine{
+		glm::vec2(sprite.pos.x - c * sprite.origin.x + s * sprite.origin.y,
+		          sprite.pos.y - s * sprite.origin.x - c * sprite.origin.y),
+		glm::vec2(c * size.x, s * size.x),
+		glm::vec2(-s * size.y, c * size.y),
+	};
+}
+
+template <typename Vertex>
+static inline void
+writeQuad(Vertex *v, const TransformedSprite &sprite, glm::vec2 uvPos, glm::vec2 uvSize)
+{
+	const auto [t, ex, ey] = getAffine(sprite);
+	v[0].pos = t;
+	v[1].pos = t + ey;
+	v[2].pos = t + ex;
+	v[3].pos = t + ex + ey;
+	for (unsigned i = 0; i < 4; ++i)
+	{
+		v[i].uv = Quad::units[i] * uvSize + uvPos;
+	}
+}
 }
 
 bool
-RenderTarget::create(const Window &window)
+RenderTarget::create(const Window &window, bool instancing)
 {
+	mInstancing = instancing;
 	mWhiteTexture.create(1, 1, &Color::White);
+	mPlaceholderTexture.create(1, 1, &PLACEHOLDER_COLOR);
+	mThreadPool.create(std::max(std::thread::hardware_concurrency(), 1U) - 1);
+	mGpuTimer.create(static_cast<unsigned>(RenderPass::Count));
 
 	// shader creation and configuration
 	mTextureShader.create();
@@ -34,19 +156,72 @@ RenderTarget::create(const Window &window)
 	mTextureShader.attachFile(ShaderType::Fragment, "assets/shaders/texture.fs");
 	mTextureShader.link();
 
-	mUniformColorShader.create();
-	mUniformColorShader.attachFile(ShaderType::Vertex, "assets/shaders/simple.vs");
-	mUniformColorShader.attachFile(ShaderType::Fragment, "assets/shaders/uniformcolor.fs");
-	mUniformColorShader.link();
+	mColorShader.create();
+	mColorShader.attachFile(ShaderType::Vertex, "assets/shaders/default.vert");
+	mColorShader.attachFile(ShaderType::Fragment, "assets/shaders/default.frag");
+	mColorShader.link();
+
+	mArrayShader.create();
+	mArrayShader.attachFile(ShaderType::Vertex, "assets/shaders/array.vert");
+	mArrayShader.attachFile(ShaderType::Fragment, "assets/shaders/array.frag");
+	mArrayShader.link();
+
+	mStaticShader.create();
+	mStaticShader.attachFile(ShaderType::Vertex, "assets/shaders/tilemap.vert");
+	mStaticShader.attachFile(ShaderType::Fragment, "assets/shaders/array.frag");
+	mStaticShader.link();
 
-	// bind a buffer to allow calling glVertexAttribPointer()
-	glCheck(glGenBuffers(1, &mVBO));
-	glCheck(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-	glCheck(glGenBuffers(1, &mEBO));
+	mParticleShader.create();
+	mParticleShader.attachFile(ShaderType::Vertex, "assets/shaders/particle.vert");
+	mParticleShader.attachFile(ShaderType::Fragment, "assets/shaders/array.frag");
+	mParticleShader.link();
+
+	if (mInstancing)
+	{
+		mSpriteShader.create();
+		mSpriteShader.attachFile(ShaderType::Vertex, "assets/shaders/sprite.vs");
+		mSpriteShader.attachFile(ShaderType::Fragment, "assets/shaders/default.frag");
+		mSpriteShader.link();
+
+		mArraySpriteShader.create();
+		mArraySpriteShader.attachFile(ShaderType::Vertex, "assets/shaders/sprite.vs");
+		mArraySpriteShader.attachFile(ShaderType::Fragment, "assets/shaders/array.frag");
+		mArraySpriteShader.link();
+	}
+
+	// the shared uniforms are read by all the programs
+	glCheck(glGenBuffers(1, &mGlobalsUBO));
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, mGlobalsUBO);
+	glCheck(glBufferData(GL_UNIFORM_BUFFER, sizeof(Globals), nullptr, GL_DYNAMIC_DRAW));
+	glCheck(glBindBufferBase(GL_UNIFORM_BUFFER, GLOBALS_BINDING, mGlobalsUBO));
+	for (auto shader : { &mTextureShader, &mColorShader, &mArrayShader,
+	                     &mStaticShader, &mParticleShader })
+	{
+		shader->bindUniformBlock("Globals", GLOBALS_BINDING);
+	}
+	if (mInstancing)
+	{
+		mSpriteShader.bindUniformBlock("Globals", GLOBALS_BINDING);
+		mArraySpriteShader.bindUniformBlock("Globals", GLOBALS_BINDING);
+	}
+
+	// every batch is made of quads sharing the same index pattern,
+	// the 32 bits indices are created only when needed
+	mQuadEBO = createQuadIndices<std::uint16_t>(MAX_BATCH_QUADS);
+	mQuadLimit = MAX_BATCH_QUADS;
+	mWideIndices = false;
+
+	// streaming buffer, it must be bound to allow calling
+	// glVertexAttribPointer()
+	mVertexBuffer.create(GL_ARRAY_BUFFER, STREAM_REGION_SIZE);
+
+	// the texts keep their glyphs in one buffer, it grows as needed
+	mTextBuffer.create(TEXT_BUFFER_QUADS);
 
 	// layout for PosUV
 	glCheck(glGenVertexArrays(1, &mPosUVVAO));
-	glCheck(glBindVertexArray(mPosUVVAO));
+	GLState::bindVertexArray(mPosUVVAO);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadEBO);
 	glCheck(glEnableVertexAttribArray(0));
 	glCheck(glVertexAttribPointer(
 		        0, 2, GL_FLOAT, GL_FALSE, sizeof(PosUV),
@@ -58,7 +233,8 @@ RenderTarget::create(const Window &window)
 
 	// layout for PosUVColor
 	glCheck(glGenVertexArrays(1, &mPosUVColorVAO));
-	glCheck(glBindVertexArray(mPosUVColorVAO));
+	GLState::bindVertexArray(mPosUVColorVAO);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadEBO);
 	glCheck(glEnableVertexAttribArray(0));
 	glCheck(glVertexAttribPointer(
 		        0, 2, GL_FLOAT, GL_FALSE, sizeof(PosUVColor),
@@ -72,6 +248,36 @@ RenderTarget::create(const Window &window)
 		        2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PosUVColor),
 		        reinterpret_cast<GLvoid*>(offsetof(PosUVColor, color))));
 
+	// layout for PosUVColorLayer
+	glCheck(glGenVertexArrays(1, &mPosUVColorLayerVAO));
+	GLState::bindVertexArray(mPosUVColorLayerVAO);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadEBO);
+	glCheck(glEnableVertexAttribArray(0));
+	glCheck(glVertexAttribPointer(
+		        0, 2, GL_FLOAT, GL_FALSE, sizeof(PosUVColorLayer),
+		        reinterpret_cast<GLvoid*>(offsetof(PosUVColorLayer, pos))));
+	glCheck(glEnableVertexAttribArray(1));
+	glCheck(glVertexAttribPointer(
+		        1, 2, GL_FLOAT, GL_FALSE, sizeof(PosUVColorLayer),
+		        reinterpret_cast<GLvoid*>(offsetof(PosUVColorLayer, uv))));
+	glCheck(glEnableVertexAttribArray(2));
+	glCheck(glVertexAttribPointer(
+		        2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PosUVColorLayer),
+		        reinterpret_cast<GLvoid*>(offsetof(PosUVColorLayer, color))));
+	glCheck(glEnableVertexAttribArray(3));
+	glCheck(glVertexAttribPointer(
+		        3, 1, GL_FLOAT, GL_FALSE, sizeof(PosUVColorLayer),
+		        reinterpret_cast<GLvoid*>(offsetof(PosUVColorLayer, layer))));
+
+	// layout for SpriteInstance, the pointers are set when drawing
+	glCheck(glGenVertexArrays(1, &mSpriteVAO));
+	GLState::bindVertexArray(mSpriteVAO);
+	for (unsigned attrib = 0; attrib < 7; ++attrib)
+	{
+		glCheck(glEnableVertexAttribArray(attrib));
+		glCheck(glVertexAttribDivisor(attrib, 1));
+	}
+
 	auto size = window.getSize();
 	setViewport(size.x, size.y);
 	return true;
@@ -80,90 +286,630 @@ RenderTarget::create(const Window &window)
 void
 RenderTarget::destroy()
 {
-	glCheck(glBindVertexArray(0));
-	glCheck(glDeleteVertexArrays(1, &mPosUVColorVAO));
-	glCheck(glDeleteVertexArrays(1, &mPosUVVAO));
-	glCheck(glDeleteBuffers(1, &mEBO));
-	glCheck(glDeleteBuffers(1, &mVBO));
+	GLState::bindVertexArray(0);
+	for (auto vao : { mSpriteVAO, mPosUVColorLayerVAO, mPosUVColorVAO, mPosUVVAO })
+	{
+		GLState::forgetVertexArray(vao);
+		glCheck(glDeleteVertexArrays(1, &vao));
+	}
+	mThreadPool.destroy();
+	mGpuTimer.destroy();
+	mVertexBuffer.destroy();
+	mTextBuffer.destroy();
+	GLState::forgetBuffer(mGlobalsUBO);
+	glCheck(glDeleteBuffers(1, &mGlobalsUBO));
+	GLState::forgetBuffer(mQuadEBO);
+	glCheck(glDeleteBuffers(1, &mQuadEBO));
+	if (mWideQuadEBO)
+	{
+		GLState::forgetBuffer(mWideQuadEBO);
+		glCheck(glDeleteBuffers(1, &mWideQuadEBO));
+		mWideQuadEBO = 0;
+	}
 }
 
 void
 RenderTarget::setViewport(unsigned width, unsigned height)
 {
-	glm::mat4 proj = glm::ortho(
-		0.0f, static_cast<GLfloat>(width),
-		static_cast<GLfloat>(height), 0.0f,
-		-1.0f, 1.0f);
-	mTextureShader.use();
-	mTextureShader.getUniform("projection").setMatrix4(proj);
-	mUniformColorShader.use();
-	mUniformColorShader.getUniform("projection").setMatrix4(proj);
+	mViewport = glm::ivec2(width, height);
+	mWindowView.reset(FloatRect(glm::vec2(0.f), glm::vec2(mViewport)));
+	if (!mRenderTexture)
+	{
+		setView(mWindowView);
+	}
+}
+
+void
+RenderTarget::setRenderTexture(RenderTexture *texture)
+{
+	// NOTE: the recorded commands belong to the previous target
+	flush();
+	if (!mRenderTexture)
+	{
+		mWindowView = mView;
+	}
+	mRenderTexture = texture;
+	if (texture)
+	{
+		// NOTE: the rows of a texture go upwards, the flipped
+		// projection also flips the winding of the quads
+		const auto size = texture->getSize();
+		GLState::bindFramebuffer(texture->getNativeHandle());
+		glCheck(glViewport(0, 0, size.x, size.y));
+		glCheck(glFrontFace(GL_CW));
+		setView(View(FloatRect(glm::vec2(0.f), glm::vec2(size))));
+	}
+	else
+	{
+		GLState::bindFramebuffer(mWindowTexture ? mWindowTexture->getNativeHandle() : 0);
+		glCheck(glViewport(0, 0, mViewport.x, mViewport.y));
+		glCheck(glFrontFace(mWindowTexture ? GL_CW : GL_CCW));
+		setView(mWindowView);
+	}
+}
+
+void
+RenderTarget::setWindowTexture(RenderTexture *texture)
+{
+	flush();
+	mWindowTexture = texture;
+	if (!mRenderTexture)
+	{
+		setRenderTexture(nullptr);
+	}
+}
+
+void
+RenderTarget::setView(const View &view)
+{
+	mView = view;
+	mCullRect = view.getBounds();
+	if (mRenderTexture || mWindowTexture)
+	{
+		setTransforms(glm::scale(glm::mat4(1.f), glm::vec3(1.f, -1.f, 1.f))
+		              * view.getProjection(),
+		              view.getViewMatrix());
+	}
+	else
+	{
+		setTransforms(view.getProjection(), view.getViewMatrix());
+	}
+}
+
+const View &
+RenderTarget::getView() const
+{
+	return mView;
+}
+
+void
+RenderTarget::setTransforms(const glm::mat4 &projection, const glm::mat4 &view)
+{
+	// NOTE: the recorded commands use the old transforms
+	flush();
+
+	const auto size = mRenderTexture ? mRenderTexture->getSize() : mViewport;
+	mGlobals.projection = projection;
+	mGlobals.view = view;
+	mGlobals.viewport = glm::vec2(size);
+	mGlobalsDirty = true;
+}
+
+void
+RenderTarget::setTime(float seconds)
+{
+	mGlobals.time = seconds;
+	mGlobalsDirty = true;
 }
 
 void
 RenderTarget::clear(Color color)
 {
+	flush();
+
 	glm::vec4 clearColor(color);
+	mGpuTimer.mark(static_cast<unsigned>(RenderPass::Clear));
 	glCheck(glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a));
 	glCheck(glClear(GL_COLOR_BUFFER_BIT));
+	mGpuTimer.stop();
+}
+
+void
+RenderTarget::beginFrame()
+{
+	// NOTE: the index size changes only between frames because the
+	// recorded commands depend on the quad limit
+	flush();
+	bool wide = mIndexType == IndexType::UInt32;
+	if (mIndexType == IndexType::Auto)
+	{
+		// widen when the last frame had to split a batch and narrow
+		// again once the batches shrink
+		wide = mStats.batchSplits > 0
+			|| (mWideIndices && mStats.largestBatch > MAX_BATCH_QUADS / 2);
+	}
+	setWideIndices(wide);
+
+	mStats = RenderStats{};
+	mLastProgram = mLastTexture = -1U;
+	mGpuTimer.beginFrame();
+}
+
+void
+RenderTarget::setIndexType(IndexType type)
+{
+	mIndexType = type;
+}
+
+void
+RenderTarget::setWideIndices(bool wide)
+{
+	if (wide && mWideQuadEBO == 0)
+	{
+		mWideQuadEBO = createQuadIndices<std::uint32_t>(MAX_WIDE_BATCH_QUADS);
+	}
+	mWideIndices = wide;
+	mQuadLimit = wide ? MAX_WIDE_BATCH_QUADS : MAX_BATCH_QUADS;
+}
+
+const RenderStats &
+RenderTarget::getStats() const
+{
+	return mStats;
+}
+
+float
+RenderTarget::getGpuTime(RenderPass pass) const
+{
+	return mGpuTimer.getMilliseconds(static_cast<unsigned>(pass));
+}
+
+void
+RenderTarget::setLayer(unsigned layer)
+{
+	mLayerKey = static_cast<std::uint64_t>(layer & 0xFF) << LAYER_SHIFT;
+}
+
+void
+RenderTarget::setBlendMode(BlendMode mode)
+{
+	mBlendKey = static_cast<std::uint64_t>(mode) << BLEND_SHIFT;
+}
+
+std::size_t
+RenderTarget::getStride(Program program)
+{
+	switch (program)
+	{
+	case Program::Texture:
+		return sizeof(PosUV);
+	case Program::Color:
+		return sizeof(PosUVColor);
+	case Program::Array:
+		return sizeof(PosUVColorLayer);
+	case Program::Sprite:
+	case Program::ArraySprite:
+		return sizeof(SpriteInstance);
+	case Program::Static:
+	case Program::StaticText:
+	case Program::Particles:
+		break;
+	}
+	return 0;
+}
+
+bool
+RenderTarget::isInstanced(Program program)
+{
+	return program == Program::Sprite || program == Program::ArraySprite;
+}
+
+void *
+RenderTarget::record(RenderPass pass, Program program, unsigned texture, unsigned count)
+{
+	// NOTE: quads are made of 4 vertices, sprites of one instance
+	const bool instanced = isInstanced(program);
+	const std::size_t stride = getStride(program);
+	const std::size_t size = count * (instanced ? stride : 4 * stride);
+
+	if (!mMapped)
+	{
+		map(size + stride);
+	}
+	auto base = mVertexBuffer.getOffset();
+	auto offset = alignUp(base + mMappedUsed, stride);
+	if (offset + size > base + mMappedSize)
+	{
+		// NOTE: continue in the next region, the commands keep their
+		// order; they are submitted early only when the ring would
+		// wrap over their vertices
+		unmap();
+		if (mVertexBuffer.getPendingRegions() == StreamBuffer::RegionCount)
+		{
+			flush();
+		}
+		map(size + stride);
+		base = mVertexBuffer.getOffset();
+		offset = alignUp(base, stride);
+	}
+	mMappedUsed = offset + size - base;
+	void *vertices = mMapped + (offset - base);
+	const unsigned first = offset / stride;
+
+	const std::uint64_t key = mLayerKey | mBlendKey
+		| static_cast<std::uint64_t>(program) << PROGRAM_SHIFT
+		| (texture & TEXTURE_MASK) << TEXTURE_SHIFT;
+
+	// extend the last command if it has the same state and its
+	// vertices are contiguous
+	if (!mCommands.empty())
+	{
+		auto &last = mCommands.back();
+		const unsigned end = last.first + (instanced ? last.count : last.count * 4);
+		if (sameState(last.key, key)
+		    && last.texture == texture
+		    && last.pass == static_cast<unsigned>(pass)
+		    && end == first)
+		{
+			if (instanced || last.count + count <= mQuadLimit)
+			{
+				last.count += count;
+				return vertices;
+			}
+			mStats.batchSplits++;
+		}
+	}
+
+	assert(mCommands.size() < SEQUENCE_MASK && "Too many commands");
+	mCommands.push_back(Command{
+			key | mCommands.size(),
+			texture,
+			first,
+			count,
+			static_cast<unsigned>(pass),
+		});
+	return vertices;
+}
+
+void
+RenderTarget::map(std::size_t minSize)
+{
+	// NOTE: map what is left of the current region, the flushes in
+	// the middle of a frame must not waste the rest of it; a new
+	// region is started only when the current one is almost full.
+	// The sub-allocations are aligned by record() to the size of
+	// their vertices
+	mMappedSize = mVertexBuffer.getRemaining();
+	if (mMappedSize < std::max(minSize, MIN_MAPPED_SIZE))
+	{
+		mMappedSize = mVertexBuffer.getRegionSize();
+	}
+	mMappedUsed = 0;
+	mMapped = static_cast<std::byte*>(mVertexBuffer.map(mMappedSize, 1));
+}
+
+void
+RenderTarget::unmap()
+{
+	mStats.uploadedBytes += mMappedUsed;
+	mVertexBuffer.unmap(mMappedUsed);
+	mMapped = nullptr;
+	mMappedSize = mMappedUsed = 0;
+}
+
+void
+RenderTarget::flush()
+{
+	if (mMapped)
+	{
+		unmap();
+	}
+
+	// NOTE: the glyphs rendered during the frame are uploaded once
+	// before their first use
+	for (auto font : mFonts)
+	{
+		font->commit();
+	}
+	mFonts.clear();
+
+	if (mCommands.empty())
+	{
+		return;
+	}
+	if (mGlobalsDirty)
+	{
+		GLState::bindBuffer(GL_UNIFORM_BUFFER, mGlobalsUBO);
+		glCheck(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(mGlobals), &mGlobals));
+		mStats.uploadedBytes += sizeof(mGlobals);
+		mGlobalsDirty = false;
+	}
+
+	std::sort(mCommands.begin(), mCommands.end(),
+	          [](const Command &a, const Command &b) {
+		          return a.key < b.key;
+	          });
+
+	// NOTE: the commands with the same state are adjacent and
+	// still sorted by sequence
+	const auto *end = mCommands.data() + mCommands.size();
+	for (const auto *begin = mCommands.data(); begin != end;)
+	{
+		auto it = begin + 1;
+		while (it != end
+		       && sameState(it->key, begin->key)
+		       && it->texture == begin->texture
+		       && it->pass == begin->pass)
+		{
+			++it;
+		}
+
+		mGpuTimer.mark(begin->pass);
+		mStats.batches++;
+		applyState(*begin);
+		const auto program = static_cast<Program>(
+			(begin->key >> PROGRAM_SHIFT) & FIELD_MASK);
+		if (program == Program::Static)
+		{
+			drawStatic(begin, it);
+		}
+		else if (program == Program::Particles)
+		{
+			drawParticles(begin, it);
+		}
+		else if (isInstanced(program))
+		{
+			drawInstances(begin, it);
+		}
+		else
+		{
+			drawQuads(begin, it, program);
+		}
+		begin = it;
+	}
+	mGpuTimer.stop();
+	mVertexBuffer.fence();
+	mCommands.clear();
+	mStaticDraws.clear();
+	mParticleDraws.clear();
 }
 
 void
-RenderTarget::reserve(unsigned vertexCount, std::span<const std::uint16_t> indices)
+RenderTarget::applyState(const Command &command)
 {
-	auto base = mVertexCount - mVertexOffset;
-	if (base + vertexCount > UINT16_MAX)
+	switch (static_cast<BlendMode>((command.key >> BLEND_SHIFT) & FIELD_MASK))
 	{
-		saveBatch();
-		base = 0;
+	case BlendMode::Alpha:
+		GLState::enableBlend(true);
+		GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		break;
+	case BlendMode::Additive:
+		GLState::enableBlend(true);
+		GLState::blendFunc(GL_SRC_ALPHA, GL_ONE);
+		break;
+	case BlendMode::None:
+		GLState::enableBlend(false);
+		break;
 	}
-	mVertexCount += vertexCount;
-	for (auto i : indices)
+
+	GLenum target = GL_TEXTURE_2D;
+	switch (static_cast<Program>((command.key >> PROGRAM_SHIFT) & FIELD_MASK))
 	{
-		mIndices.push_back(base + i);
+	case Program::Texture:
+		mTextureShader.use();
+		break;
+	case Program::Color:
+		mColorShader.use();
+		break;
+	case Program::Sprite:
+		mSpriteShader.use();
+		break;
+	case Program::Array:
+		mArrayShader.use();
+		target = GL_TEXTURE_2D_ARRAY;
+		break;
+	case Program::ArraySprite:
+		mArraySpriteShader.use();
+		target = GL_TEXTURE_2D_ARRAY;
+		break;
+	case Program::Static:
+		mStaticShader.use();
+		target = GL_TEXTURE_2D_ARRAY;
+		break;
+	case Program::StaticText:
+		mColorShader.use();
+		break;
+	case Program::Particles:
+		mParticleShader.use();
+		target = GL_TEXTURE_2D_ARRAY;
+		break;
+	}
+
+	GLState::bindTexture(0, target, command.texture);
+
+	// NOTE: the redundant binds are elided by GLState, count the
+	// changes between the batches
+	const auto program = (command.key >> PROGRAM_SHIFT) & FIELD_MASK;
+	if (program != mLastProgram)
+	{
+		mStats.programSwitches++;
+		mLastProgram = program;
+	}
+	if (command.texture != mLastTexture)
+	{
+		mStats.textureBinds++;
+		mLastTexture = command.texture;
 	}
-	mIndexCount += indices.size();
 }
 
 void
-RenderTarget::startBatch()
+RenderTarget::drawStatic(const Command *begin, const Command *end)
 {
-	mIndices.clear();
-	mBatches.clear();
-	mVertexOffset = mVertexCount = 0;
-	mIndexOffset = mIndexCount = 0;
+	auto offset = mStaticShader.getUniform("Offset");
+	for (auto it = begin; it != end; ++it)
+	{
+		const auto &draw = mStaticDraws[it->first];
+		offset.setVector2f(draw.offset);
+		GLState::bindVertexArray(draw.vao);
+		glCheck(glDrawElements(
+			        GL_TRIANGLES,
+			        draw.count * 6,
+			        GL_UNSIGNED_INT,
+			        reinterpret_cast<GLvoid*>(draw.first * 6 * sizeof(GLuint))));
+		mStats.drawCalls++;
+		mStats.vertices += draw.count * 4;
+		mStats.indices += draw.count * 6;
+	}
 }
 
 void
-RenderTarget::saveBatch()
+RenderTarget::drawParticles(const Command *begin, const Command *end)
 {
-	mBatches.emplace_back(
-		mVertexOffset,
-		mIndexOffset * sizeof(mIndices[0]),
-		mIndexCount - mIndexOffset);
-	mVertexOffset = mVertexCount;
-	mIndexOffset = mIndexCount;
+	for (auto it = begin; it != end; ++it)
+	{
+		const auto &system = *mParticleDraws[it->first];
+		const auto frames = system.getFrames();
+		mParticleShader.getUniform("Now").setFloat(system.getTime());
+		mParticleShader.getUniform("Frames").setVector4fv(
+			reinterpret_cast<const float(*)[4]>(frames.data()),
+			frames.size());
+		mParticleShader.getUniform("FrameCount").setInteger(frames.size());
+		mParticleShader.getUniform("Size").setVector2f(system.getSize());
+		mParticleShader.getUniform("Layer").setFloat(system.getLayer());
+
+		// NOTE: the attributes of the particles are per instance,
+		// the corners come from the vertex index
+		GLState::bindVertexArray(system.getVertexArray());
+		glCheck(glDrawArraysInstanced(
+			        GL_TRIANGLE_STRIP,
+			        0,
+			        4,
+			        system.getParticleCount()));
+		mStats.drawCalls++;
+		mStats.vertices += system.getParticleCount() * 4;
+	}
+}
+
+bool
+RenderTarget::isVisible(glm::vec2 pos, glm::vec2 size) const
+{
+	return pos.x < mCullRect.pos.x + mCullRect.size.x
+		&& pos.x + size.x > mCullRect.pos.x
+		&& pos.y < mCullRect.pos.y + mCullRect.size.y
+		&& pos.y + size.y > mCullRect.pos.y;
 }
 
 void
-RenderTarget::drawBuffers() const
+RenderTarget::drawQuads(const Command *begin, const Command *end, Program program)
 {
-	// upload the indices
-	glCheck(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO));
-	glCheck(glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-	                     mIndices.size() * sizeof(mIndices[0]),
-	                     mIndices.data(),
-	                     GL_STREAM_DRAW));
+	// merge the contiguous ranges
+	mDrawFirsts.clear();
+	mDrawCounts.clear();
+	unsigned first = begin->first;
+	unsigned count = begin->count;
+	for (auto it = begin + 1; it != end; ++it)
+	{
+		if (it->first == first + count * 4
+		    && count + it->count <= mQuadLimit)
+		{
+			count += it->count;
+			continue;
+		}
+		mDrawFirsts.push_back(first);
+		mDrawCounts.push_back(count * std::size(Quad::indices));
+		first = it->first;
+		count = it->count;
+	}
+	mDrawFirsts.push_back(first);
+	mDrawCounts.push_back(count * std::size(Quad::indices));
+	for (auto indexCount : mDrawCounts)
+	{
+		const unsigned quads = indexCount / std::size(Quad::indices);
+		mStats.vertices += quads * 4;
+		mStats.indices += indexCount;
+		mStats.largestBatch = std::max(mStats.largestBatch, quads);
+	}
+	mStats.drawCalls++;
 
-	// draw all the batches
-	for (const auto &batch : mBatches)
+	switch (program)
+	{
+	case Program::Texture:
+		GLState::bindVertexArray(mPosUVVAO);
+		break;
+	case Program::Color:
+		GLState::bindVertexArray(mPosUVColorVAO);
+		break;
+	case Program::Array:
+		GLState::bindVertexArray(mPosUVColorLayerVAO);
+		break;
+	case Program::StaticText:
+		GLState::bindVertexArray(mTextBuffer.getVertexArray());
+		break;
+	default:
+		assert(false && "Not a quad program");
+		break;
+	}
+
+	// NOTE: the index buffer is part of the VAO state, the binding
+	// is elided unless the index size changed or the VAO did
+	const GLenum indexType = mWideIndices ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mWideIndices ? mWideQuadEBO : mQuadEBO);
+	if (mDrawCounts.size() == 1)
 	{
 		glCheck(glDrawElementsBaseVertex(
 			        GL_TRIANGLES,
-			        batch.indexCount,
-			        GL_UNSIGNED_SHORT,
-			        reinterpret_cast<GLvoid*>(batch.indexOffset),
-			        batch.vertexOffset));
+			        mDrawCounts[0],
+			        indexType,
+			        nullptr,
+			        mDrawFirsts[0]));
+	}
+	else
+	{
+		mDrawIndices.assign(mDrawCounts.size(), nullptr);
+		glCheck(glMultiDrawElementsBaseVertex(
+			        GL_TRIANGLES,
+			        mDrawCounts.data(),
+			        indexType,
+			        mDrawIndices.data(),
+			        mDrawCounts.size(),
+			        mDrawFirsts.data()));
+	}
+}
+
+void
+RenderTarget::drawInstances(const Command *begin, const Command *end)
+{
+	GLState::bindVertexArray(mSpriteVAO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, mVertexBuffer.getNativeHandle());
+	for (auto it = begin; it != end;)
+	{
+		// merge the contiguous ranges
+		const unsigned first = it->first;
+		unsigned count = it->count;
+		for (++it; it != end && it->first == first + count; ++it)
+		{
+			count += it->count;
+		}
+
+		// NOTE: GL 3.3 has no base instance, point the attributes
+		// directly to the first instance
+		const auto offset = first * sizeof(SpriteInstance);
+		const auto attrib = [offset](unsigned index, GLint size, GLenum type,
+		                             GLboolean normalized, std::size_t member) {
+			glCheck(glVertexAttribPointer(
+				        index, size, type, normalized, sizeof(SpriteInstance),
+				        reinterpret_cast<GLvoid*>(offset + member)));
+		};
+		attrib(0, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, pos));
+		attrib(1, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, axisX));
+		attrib(2, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, axisY));
+		attrib(3, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, uvPos));
+		attrib(4, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, uvSize));
+		attrib(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(SpriteInstance, color));
+		attrib(6, 1, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, layer));
+		glCheck(glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count));
+		mStats.drawCalls++;
+		mStats.vertices += count * 4;
 	}
 }
 
@@ -177,139 +923,413 @@ RenderTarget::draw(const std::string &text, glm::vec2 pos, Font &font, Color col
 
 	// NOTE: this ensures the glyphs are rendered in the texture before drawing
 	std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> cv;
-	for (auto codepoint : cv.from_bytes(text))
+	const auto codepoints = cv.from_bytes(text);
+	for (auto codepoint : codepoints)
 	{
 		font.getGlyph(codepoint);
 	}
+	useFont(font);
 
-	mUniformColorShader.use();
-	mUniformColorShader.getUniform("uniformColor").setVector4f(color);
-	font.getTexture().bind(0);
-
-	mPosUV.clear();
-	startBatch();
+	const auto texture = font.getTexture().getNativeHandle();
 	pos.y += font.getLineHeight();
-	for (auto codepoint : cv.from_bytes(text))
+	for (auto codepoint : codepoints)
 	{
 		const auto &g = font.getGlyph(codepoint);
 		pos.x += g.bearing.x;
 		pos.y -= g.bearing.y;
-		reserve(4, indices);
-		for (auto unit : units)
+		auto v = static_cast<PosUVColor*>(record(RenderPass::Text, Program::Color, texture, 1));
+		writeQuad(v, pos, g.size, g.uvPos, g.uvSize);
+		for (unsigned i = 0; i < 4; ++i)
 		{
-			PosUV v;
-			v.pos = g.size * unit + pos;
-			v.uv = g.uvSize * unit + g.uvPos;
-			mPosUV.push_back(v);
+			v[i].color = color;
 		}
 		pos.x += g.advance - g.bearing.x;
 		pos.y += g.bearing.y;
 	}
-	saveBatch();
+}
 
-	glCheck(glBindVertexArray(mPosUVVAO));
-	glCheck(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-	glCheck(glBufferData(GL_ARRAY_BUFFER,
-	                     mPosUV.size() * sizeof(mPosUV[0]),
-	                     mPosUV.data(),
-	                     GL_STREAM_DRAW));
+void
+RenderTarget::draw(Text &text)
+{
+	if (!text.update())
+	{
+		return;
+	}
+	useFont(*text.getFont());
 
-	drawBuffers();
+	// NOTE: the glyphs stay in the shared text buffer, the texts
+	// with the same font are drawn together like the streamed quads
+	assert(text.getQuadCount() <= MAX_BATCH_QUADS && "Text too long");
+	const unsigned first = text.commit(mTextBuffer);
+	const std::uint64_t key = mLayerKey | mBlendKey
+		| static_cast<std::uint64_t>(Program::StaticText) << PROGRAM_SHIFT
+		| (text.getTexture() & TEXTURE_MASK) << TEXTURE_SHIFT;
+	assert(mCommands.size() < SEQUENCE_MASK && "Too many commands");
+	mCommands.push_back(Command{
+			key | mCommands.size(),
+			text.getTexture(),
+			first,
+			text.getQuadCount(),
+			static_cast<unsigned>(RenderPass::Text),
+		});
+}
+
+void
+RenderTarget::useFont(Font &font)
+{
+	if (std::find(mFonts.begin(), mFonts.end(), &font) == mFonts.end())
+	{
+		mFonts.push_back(&font);
+	}
+}
+
+void
+RenderTarget::draw(const ParticleSystem &particles)
+{
+	if (particles.getParticleCount() == 0 || particles.getFrames().empty())
+	{
+		return;
+	}
+
+	// NOTE: the particles never leave the GPU, the command refers
+	// to the system which is drawn in flush()
+	const std::uint64_t key = mLayerKey | mBlendKey
+		| static_cast<std::uint64_t>(Program::Particles) << PROGRAM_SHIFT
+		| (particles.getTexture() & TEXTURE_MASK) << TEXTURE_SHIFT;
+	assert(mCommands.size() < SEQUENCE_MASK && "Too many commands");
+	mCommands.push_back(Command{
+			key | mCommands.size(),
+			particles.getTexture(),
+			static_cast<unsigned>(mParticleDraws.size()),
+			1,
+			static_cast<unsigned>(RenderPass::Particles),
+		});
+	mParticleDraws.push_back(&particles);
 }
 
 void
 RenderTarget::draw(const RectangleShape &rect)
 {
-	mUniformColorShader.use();
-	mUniformColorShader.getUniform("uniformColor").setVector4f(rect.getColor());
-	mWhiteTexture.bind(0);
-	mPosUV.clear();
-	startBatch();
-	reserve(4, indices);
+	auto v = static_cast<PosUVColor*>(record(
+		RenderPass::Shapes,
+		Program::Color,
+		mWhiteTexture.getNativeHandle(),
+		1));
 
 	auto transform = rect.getTransform();
 	auto size = rect.getSize();
-	for (auto unit : units)
+	Color color = rect.getColor();
+	for (auto unit : Quad::units)
 	{
-		PosUV v;
 		glm::vec4 pos = glm::vec4(unit * size, 0.f, 1.f);
-		v.pos = transform * pos;
-		v.uv = unit;
-		mPosUV.push_back(v);
+		v->pos = transform * pos;
+		v->uv = unit;
+		v->color = color;
+		++v;
 	}
-	saveBatch();
-
-	glCheck(glBindVertexArray(mPosUVVAO));
-	glCheck(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-	glCheck(glBufferData(GL_ARRAY_BUFFER,
-	                     mPosUV.size() * sizeof(mPosUV[0]),
-	                     mPosUV.data(),
-	                     GL_STREAM_DRAW));
-
-	drawBuffers();
 }
 
 void
 RenderTarget::draw(const Texture &texture, glm::vec2 pos)
 {
-	auto size = texture.getSize();
+	const auto &source = texture.isReady() ? texture : mPlaceholderTexture;
+	auto v = static_cast<PosUV*>(record(
+		RenderPass::Textures,
+		Program::Texture,
+		source.getNativeHandle(),
+		1));
+	writeQuad(v, pos, texture.getSize(), glm::vec2(0.f), glm::vec2(1.f));
+}
 
-	mPosUV.clear();
-	startBatch();
-	reserve(4, indices);
-	for (auto unit : units)
+void
+RenderTarget::draw(const TileMap &map, float top)
+{
+	const auto [first, count] = map.getVisibleQuads(
+		top + mCullRect.pos.y,
+		mCullRect.size.y);
+	if (count == 0)
 	{
-		PosUV v;
-		v.pos = unit * size + pos;
-		v.uv = unit;
-		mPosUV.push_back(v);
+		return;
 	}
-	saveBatch();
 
-	mTextureShader.use();
-	texture.bind(0);
-	glCheck(glBindVertexArray(mPosUVVAO));
-	glCheck(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-	glCheck(glBufferData(GL_ARRAY_BUFFER,
-	                     mPosUV.size() * sizeof(mPosUV[0]),
-	                     mPosUV.data(),
-	                     GL_STREAM_DRAW));
-
-	drawBuffers();
+	// NOTE: the vertices are already on the GPU, the command only
+	// refers to the range of the static buffer
+	const std::uint64_t key = mLayerKey | mBlendKey
+		| static_cast<std::uint64_t>(Program::Static) << PROGRAM_SHIFT
+		| (map.getTexture() & TEXTURE_MASK) << TEXTURE_SHIFT;
+	assert(mCommands.size() < SEQUENCE_MASK && "Too many commands");
+	mCommands.push_back(Command{
+			key | mCommands.size(),
+			map.getTexture(),
+			static_cast<unsigned>(mStaticDraws.size()),
+			1,
+			static_cast<unsigned>(RenderPass::Map),
+		});
+	mStaticDraws.push_back(StaticDraw{
+			map.getVertexArray(),
+			first,
+			count,
+			glm::vec2(0.f, -top),
+		});
 }
 
 void
 RenderTarget::beginFrames(const Texture &texture)
 {
-	mPosUV.clear();
-	startBatch();
-	mTextureShader.use();
-	texture.bind(0);
+	mFrameTexture = texture.getNativeHandle();
+	mFrameArray = nullptr;
+}
+
+void
+RenderTarget::beginFrames(const TextureArray &array)
+{
+	mFrameTexture = array.getNativeHandle();
+	mFrameArray = &array;
 }
 
 void
 RenderTarget::addFrame(const Frame &drw, glm::vec2 pos)
 {
-	reserve(4, indices);
-	for (auto unit : units)
+	if (mInstancing || mFrameArray)
 	{
-		mPosUV.emplace_back(
-			unit * drw.size + pos,
-			unit * drw.uvSize + drw.uvPos
-			);
+		addFrame(drw, pos, Color::White);
+		return;
+	}
+
+	if (!isVisible(pos, drw.size))
+	{
+		return;
 	}
+	auto v = static_cast<PosUV*>(record(RenderPass::Frames, Program::Texture, mFrameTexture, 1));
+	writeQuad(v, pos, drw.size, drw.uvPos, drw.uvSize);
 }
 
 void
-RenderTarget::endFrames()
+RenderTarget::addFrame(const Frame &drw, glm::vec2 pos, Color color)
 {
-	saveBatch();
+	const Sprite sprite{ &drw, pos, color };
+	addFrames(std::span(&sprite, 1));
+}
 
-	glCheck(glBindVertexArray(mPosUVVAO));
-	glCheck(glBindBuffer(GL_ARRAY_BUFFER, mVBO));
-	glCheck(glBufferData(GL_ARRAY_BUFFER,
-	                     mPosUV.size() * sizeof(mPosUV[0]),
-	                     mPosUV.data(),
-	                     GL_STREAM_DRAW));
-	drawBuffers();
+void
+RenderTarget::addFrames(std::span<const Sprite> sprites)
+{
+	// NOTE: drop the sprites outside of the view before any vertex
+	// is generated, the copy is made only when something is culled
+	const auto visible = [this](const Sprite &sprite) {
+		return isVisible(sprite.pos, sprite.frame->size);
+	};
+	if (!std::all_of(sprites.begin(), sprites.end(), visible))
+	{
+		mVisibleSprites.clear();
+		std::copy_if(sprites.begin(), sprites.end(),
+		             std::back_inserter(mVisibleSprites), visible);
+		sprites = mVisibleSprites;
+	}
+
+	const Program program = mInstancing
+		? (mFrameArray ? Program::ArraySprite : Program::Sprite)
+		: (mFrameArray ? Program::Array : Program::Color);
+	recordSprites(program, sprites);
+}
+
+void
+RenderTarget::addFrames(std::span<const TransformedSprite> sprites)
+{
+	// NOTE: the corners are within the scaled diagonal plus the
+	// origin from the position, whatever the rotation
+	const auto visible = [this](const TransformedSprite &sprite) {
+		const float radius = glm::length(sprite.frame->size * sprite.scale)
+			+ glm::length(sprite.origin);
+		return isVisible(sprite.pos - glm::vec2(radius), glm::vec2(radius * 2.f));
+	};
+	if (!std::all_of(sprites.begin(), sprites.end(), visible))
+	{
+		mVisibleTransformed.clear();
+		std::copy_if(sprites.begin(), sprites.end(),
+		             std::back_inserter(mVisibleTransformed), visible);
+		sprites = mVisibleTransformed;
+	}
+
+	const Program program = mInstancing
+		? (mFrameArray ? Program::ArraySprite : Program::Sprite)
+		: (mFrameArray ? Program::Array : Program::Color);
+	recordSprites(program, sprites);
+}
+
+template <typename T>
+void
+RenderTarget::recordSprites(Program program, std::span<const T> sprites)
+{
+	// NOTE: one stride of slack for the alignment of the vertices,
+	// the wide batches of the bigger vertices fill a region first
+	const std::size_t regionCount = mVertexBuffer.getRegionSize() / getStride(program) - 1;
+	const std::size_t maxCount = isInstanced(program)
+		? regionCount
+		: std::min<std::size_t>(mQuadLimit, regionCount / 4);
+	while (!sprites.empty())
+	{
+		const auto batch = sprites.first(std::min(sprites.size(), maxCount));
+		void *vertices = record(RenderPass::Frames, program, mFrameTexture, batch.size());
+		if (batch.size() < PARALLEL_MIN_SPRITES)
+		{
+			writeSprites(program, vertices, batch, 0, batch.size());
+		}
+		else
+		{
+			// the workers write disjoint slices of the mapped range
+			mThreadPool.parallelFor(
+				batch.size(),
+				PARALLEL_GRAIN,
+				[&](std::size_t begin, std::size_t end) {
+					writeSprites(program, vertices, batch, begin, end);
+				});
+		}
+		// NOTE: record() counts the split when the next chunk cannot
+		// extend the command of this one
+		sprites = sprites.subspan(batch.size());
+	}
+}
+
+std::pair<glm::vec2, glm::vec2>
+RenderTarget::getFrameUV(const Frame &frame) const
+{
+	// NOTE: the frame UVs are relative to the image in the layer
+	if (mFrameArray)
+	{
+		const auto scale = mFrameArray->getLayerScale(frame.layer);
+		return std::make_pair(frame.uvPos * scale, frame.uvSize * scale);
+	}
+	return std::make_pair(frame.uvPos, frame.uvSize);
+}
+
+void
+RenderTarget::writeSprites(Program program, void *vertices,
+                           std::span<const Sprite> sprites,
+                           std::size_t begin, std::size_t end) const
+{
+	switch (program)
+	{
+	case Program::Sprite:
+	case Program::ArraySprite:
+	{
+		auto i = static_cast<SpriteInstance*>(vertices) + begin;
+		for (const auto &sprite : sprites.subspan(begin, end - begin))
+		{
+			const auto [uvPos, uvSize] = getFrameUV(*sprite.frame);
+			i->pos = sprite.pos;
+			i->axisX = glm::vec2(sprite.frame->size.x, 0.f);
+			i->axisY = glm::vec2(0.f, sprite.frame->size.y);
+			i->uvPos = uvPos;
+			i->uvSize = uvSize;
+			i->color = sprite.color;
+			i->layer = sprite.frame->layer;
+			++i;
+		}
+		break;
+	}
+	case Program::Array:
+	{
+		auto v = static_cast<PosUVColorLayer*>(vertices) + begin * 4;
+		for (const auto &sprite : sprites.subspan(begin, end - begin))
+		{
+			const auto [uvPos, uvSize] = getFrameUV(*sprite.frame);
+			writeQuad(v, sprite.pos, sprite.frame->size, uvPos, uvSize);
+			for (unsigned i = 0; i < 4; ++i)
+			{
+				v[i].color = sprite.color;
+				v[i].layer = sprite.frame->layer;
+			}
+			v += 4;
+		}
+		break;
+	}
+	case Program::Color:
+	{
+		auto v = static_cast<PosUVColor*>(vertices) + begin * 4;
+		for (const auto &sprite : sprites.subspan(begin, end - begin))
+		{
+			const auto [uvPos, uvSize] = getFrameUV(*sprite.frame);
+			writeQuad(v, sprite.pos, sprite.frame->size, uvPos, uvSize);
+			for (unsigned i = 0; i < 4; ++i)
+			{
+				v[i].color = sprite.color;
+			}
+			v += 4;
+		}
+		break;
+	}
+	default:
+		assert(false && "Not a sprite program");
+		break;
+	}
+}
+
+void
+RenderTarget::writeSprites(Program program, void *vertices,
+                           std::span<const TransformedSprite> sprites,
+                           std::size_t begin, std::size_t end) const
+{
+	switch (program)
+	{
+	case Program::Sprite:
+	case Program::ArraySprite:
+	{
+		auto i = static_cast<SpriteInstance*>(vertices) + begin;
+		for (const auto &sprite : sprites.subspan(begin, end - begin))
+		{
+			const auto [uvPos, uvSize] = getFrameUV(*sprite.frame);
+			const auto [t, ex, ey] = getAffine(sprite);
+			i->pos = t;
+			i->axisX = ex;
+			i->axisY = ey;
+			i->uvPos = uvPos;
+			i->uvSize = uvSize;
+			i->color = sprite.color;
+			i->layer = sprite.frame->layer;
+			++i;
+		}
+		break;
+	}
+	case Program::Array:
+	{
+		auto v = static_cast<PosUVColorLayer*>(vertices) + begin * 4;
+		for (const auto &sprite : sprites.subspan(begin, end - begin))
+		{
+			const auto [uvPos, uvSize] = getFrameUV(*sprite.frame);
+			writeQuad(v, sprite, uvPos, uvSize);
+			for (unsigned i = 0; i < 4; ++i)
+			{
+				v[i].color = sprite.color;
+				v[i].layer = sprite.frame->layer;
+			}
+			v += 4;
+		}
+		break;
+	}
+	case Program::Color:
+	{
+		auto v = static_cast<PosUVColor*>(vertices) + begin * 4;
+		for (const auto &sprite : sprites.subspan(begin, end - begin))
+		{
+			const auto [uvPos, uvSize] = getFrameUV(*sprite.frame);
+			writeQuad(v, sprite, uvPos, uvSize);
+			for (unsigned i = 0; i < 4; ++i)
+			{
+				v[i].color = sprite.color;
+			}
+			v += 4;
+		}
+		break;
+	}
+	default:
+		assert(false && "Not a transformed sprite program");
+		break;
+	}
+}
+
+void
+RenderTarget::endFrames()
+{
+	// NOTE: the frames are submitted by flush()
 }
@@ -1,39 +1,230 @@
 #pragma once
 
+#include <cstdint>
 #include <span>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "color.hpp"
+#include "gputimer.hpp"
 #include "shader.hpp"
+#include "streambuffer.hpp"
+#include "text.hpp"
 #include "texture.hpp"
+#include "texturearray.hpp"
+#include "threadpool.hpp"
+#include "view.hpp"
 
 class Window;
 class Font;
+class ParticleSystem;
 class RectangleShape;
+class RenderTexture;
+class TileMap;
 struct Frame;
 
+// NOTE: 16 bits indices split the batches every 16384 quads
+enum class IndexType
+{
+	Auto,
+	UInt16,
+	UInt32,
+};
+
+// NOTE: the GPU time is measured separately for each pass
+enum class RenderPass
+{
+	Clear,
+	Map,
+	Frames,
+	Particles,
+	Text,
+	Shapes,
+	Textures,
+	Count,
+};
+
+/**
+ * Work submitted by a RenderTarget during a frame.
+ */
+struct RenderStats
+{
+	unsigned    drawCalls;
+	unsigned    batches;
+	unsigned    vertices;
+	unsigned    indices;
+	std::size_t uploadedBytes;
+	unsigned    textureBinds;
+	unsigned    programSwitches;
+	unsigned    batchSplits;
+	unsigned    largestBatch;
+};
+
+/**
+ * Frame drawn at @pos by RenderTarget::addFrames().
+ */
+struct Sprite
+{
+	const Frame *frame;
+	glm::vec2 pos;
+	Color color;
+};
+
+/**
+ * Frame drawn by RenderTarget::addFrames() scaled by @scale and
+ * rotated by @rotation degrees around @origin, which is placed at
+ * @pos; the transform is the same of Transformable.
+ */
+struct TransformedSprite
+{
+	const Frame *frame;
+	glm::vec2 pos;
+	glm::vec2 origin;
+	glm::vec2 scale;
+	float rotation;
+	Color color;
+};
+
+enum class BlendMode
+{
+	Alpha,
+	Additive,
+	None,
+};
+
+/**
+ * Deferred 2D renderer.
+ *
+ * The draw calls only write the vertices in the stream buffer and
+ * record a command; flush() sorts the commands by layer and state
+ * and submits them with as few GL draw calls as possible. Commands
+ * in the same layer may be reordered, use different layers when the
+ * painter's order matters. The layers are sorted between two flushes:
+ * clear(), setView() and the changes of target submit the commands
+ * recorded so far, and so does recording more vertices than the
+ * regions of the stream buffer hold (24 MB).
+ */
 class RenderTarget
 {
 public:
-	bool create(const Window &window);
+	/**
+	 * Create the target for the given @window.
+	 * @param[in] instancing draw the frames as instanced quads
+	 */
+	bool create(const Window &window, bool instancing = false);
 	void destroy();
+	/**
+	 * Resize the window area, the view is reset to cover it.
+	 */
 	void setViewport(unsigned width, unsigned height);
 
+	/**
+	 * Set the @view of the current target: the sprites outside of
+	 * its bounds are culled before their vertices are generated.
+	 */
+	void setView(const View &view);
+	const View &getView() const;
+
+	/**
+	 * Draw into @texture instead of the window, nullptr draws to
+	 * the window again. The view is reset to the whole texture and
+	 * the view of the window is restored when leaving it.
+	 */
+	void setRenderTexture(RenderTexture *texture);
+
+	/**
+	 * Redirect the drawing meant for the window into @texture, which
+	 * must be as big as the viewport; nullptr draws to the window
+	 * again. The render textures set afterwards are not affected.
+	 */
+	void setWindowTexture(RenderTexture *texture);
+
 	/**
 	 * Clear the target with the given @color.
 	 * @param[in] color
 	 */
 	void clear(Color = Color::Black);
 
+	/**
+	 * Set the time in @seconds read by the shaders.
+	 */
+	void setTime(float seconds);
+
+	/**
+	 * Set the @layer of the next draw calls: lower layers are
+	 * drawn first.
+	 */
+	void setLayer(unsigned layer);
+	void setBlendMode(BlendMode mode);
+
 	void draw(const std::string &text, glm::vec2 pos, Font &font, Color color);
+
+	/**
+	 * Draw a @text laid out in the shared text buffer, the quads are
+	 * built again only when the text changed and the texts with the
+	 * same font are drawn together.
+	 */
+	void draw(Text &text);
+
+	/**
+	 * Draw the live @particles, they are simulated and stored on
+	 * the GPU.
+	 */
+	void draw(const ParticleSystem &particles);
 	void draw(const RectangleShape &rect);
 	void draw(const Texture &texture, glm::vec2 pos);
 
+	/**
+	 * Draw the chunks of the @map visible when the row @top of the
+	 * map is at the top of the target.
+	 */
+	void draw(const TileMap &map, float top);
+
 	void beginFrames(const Texture &texture);
+	void beginFrames(const TextureArray &array);
 	void addFrame(const Frame &frame, glm::vec2 pos);
+	void addFrame(const Frame &frame, glm::vec2 pos, Color color);
+
+	/**
+	 * Add a batch of @sprites, big batches are written in parallel
+	 * by the worker threads.
+	 */
+	void addFrames(std::span<const Sprite> sprites);
+
+	/**
+	 * Add a batch of transformed @sprites, they use the same program
+	 * of the untransformed ones and share their batches.
+	 */
+	void addFrames(std::span<const TransformedSprite> sprites);
 	void endFrames();
 
+	/**
+	 * Submit the recorded commands to the GPU.
+	 */
+	void flush();
+
+	/**
+	 * Reset the statistics and start the GPU timing of a new frame.
+	 */
+	void beginFrame();
+
+	/**
+	 * Set the size of the quad indices, Auto switches to 32 bits
+	 * after a frame which had to split a batch. The change is
+	 * applied by the next beginFrame().
+	 */
+	void setIndexType(IndexType type);
+
+	/**
+	 * Get the statistics of the current frame.
+	 */
+	const RenderStats &getStats() const;
+
+	/**
+	 * Get the GPU milliseconds spent in the @pass a few frames ago.
+	 */
+	float getGpuTime(RenderPass pass) const;
+
 private:
 	struct PosUV
 	{
@@ -48,35 +239,151 @@ private:
 		uint32_t color;
 	};
 
-	struct Batch
+	struct PosUVColorLayer
+	{
+		glm::vec2 pos;
+		glm::vec2 uv;
+		uint32_t color;
+		float layer;
+	};
+
+	// NOTE: the corners are pos plus the edges axisX and axisY, which
+	// hold the size, rotation and scale of the sprite
+	struct SpriteInstance
+	{
+		glm::vec2 pos;
+		glm::vec2 axisX;
+		glm::vec2 axisY;
+		glm::vec2 uvPos;
+		glm::vec2 uvSize;
+		uint32_t color;
+		float layer;
+	};
+
+	enum class Program
 	{
-		unsigned vertexOffset;
-		unsigned indexOffset;
-		unsigned indexCount;
+		Texture,
+		Color,
+		Sprite,
+		Array,
+		ArraySprite,
+		Static,
+		StaticText,
+		Particles,
 	};
 
-	void reserve(unsigned vertexCount, std::span<const std::uint16_t> indices);
-	void startBatch();
-	void saveBatch();
-	void drawBuffers() const;
+	// NOTE: std140 layout of the Globals uniform block
+	struct Globals
+	{
+		glm::mat4 projection;
+		glm::mat4 view;
+		glm::vec2 viewport;
+		float time;
+		float padding;
+	};
+
+	struct Command
+	{
+		std::uint64_t key;
+		unsigned texture;
+		unsigned first;
+		unsigned count;
+		unsigned pass;
+	};
+
+	// NOTE: Program::Static commands store the index of the draw in the
+	// first field
+	struct StaticDraw
+	{
+		unsigned vao;
+		unsigned first;
+		unsigned count;
+		glm::vec2 offset;
+	};
+
+	void setTransforms(const glm::mat4 &projection, const glm::mat4 &view);
+
+	static std::size_t getStride(Program program);
+	static bool isInstanced(Program program);
+	void *record(RenderPass pass, Program program, unsigned texture, unsigned count);
+	void map(std::size_t minSize);
+	void unmap();
+	template <typename T>
+	void recordSprites(Program program, std::span<const T> sprites);
+	void writeSprites(Program program, void *vertices,
+	                  std::span<const Sprite> sprites,
+	                  std::size_t begin, std::size_t end) const;
+	void writeSprites(Program program, void *vertices,
+	                  std::span<const TransformedSprite> sprites,
+	                  std::size_t begin, std::size_t end) const;
+	std::pair<glm::vec2, glm::vec2> getFrameUV(const Frame &frame) const;
+
+	void drawQuads(const Command *begin, const Command *end, Program program);
+	void drawInstances(const Command *begin, const Command *end);
+	void drawStatic(const Command *begin, const Command *end);
+	void drawParticles(const Command *begin, const Command *end);
+	void applyState(const Command &command);
+	bool isVisible(glm::vec2 pos, glm::vec2 size) const;
+	void setWideIndices(bool wide);
+	void useFont(Font &font);
 
 private:
-	std::vector<std::uint16_t> mIndices;
-	std::vector<PosUV>         mPosUV;
-	std::vector<PosUVColor>    mPosUVColor;
-	std::vector<Batch>         mBatches;
+	std::vector<Command>     mCommands;
+	std::vector<StaticDraw>  mStaticDraws;
+	std::vector<const ParticleSystem*> mParticleDraws;
+	std::vector<Font*>       mFonts;
+	std::vector<Sprite>      mVisibleSprites;
+	std::vector<TransformedSprite> mVisibleTransformed;
+	std::vector<int>         mDrawFirsts;
+	std::vector<int>         mDrawCounts;
+	std::vector<const void*> mDrawIndices;
+	std::uint64_t            mLayerKey = 0;
+	std::uint64_t            mBlendKey = 0;
+
+	RenderStats  mStats{};
+	IndexType    mIndexType = IndexType::Auto;
+	bool         mWideIndices = false;
+	unsigned     mQuadLimit = 0;
+	unsigned     mLastProgram = -1U;
+	unsigned     mLastTexture = -1U;
+
+	ThreadPool   mThreadPool;
+	GpuTimer     mGpuTimer;
+	StreamBuffer mVertexBuffer;
+	TextBuffer   mTextBuffer;
+	std::byte   *mMapped = nullptr;
+	std::size_t  mMappedSize = 0;
+	std::size_t  mMappedUsed = 0;
+
+	RenderTexture *mRenderTexture = nullptr;
+	RenderTexture *mWindowTexture = nullptr;
+	glm::ivec2     mViewport{ 0 };
+	View           mView;
+	View           mWindowView;
+	FloatRect      mCullRect;
+
+	Globals      mGlobals{};
+	bool         mGlobalsDirty = true;
+	unsigned     mGlobalsUBO = 0;
 
-	unsigned mVertexOffset = 0;
-	unsigned mVertexCount = 0;
-	unsigned mIndexOffset = 0;
-	unsigned mIndexCount = 0;
+	bool         mInstancing = false;
+	unsigned     mFrameTexture = 0;
+	const TextureArray *mFrameArray = nullptr;
 
 	Texture  mWhiteTexture;
+	Texture  mPlaceholderTexture;
 	Shader   mTextureShader;
-	Shader   mUniformColorShader;
+	Shader   mColorShader;
+	Shader   mSpriteShader;
+	Shader   mArrayShader;
+	Shader   mArraySpriteShader;
+	Shader   mStaticShader;
+	Shader   mParticleShader;
 
 	unsigned mPosUVVAO = 0;
 	unsigned mPosUVColorVAO = 0;
-	unsigned mVBO = 0;
-	unsigned mEBO = 0;
+	unsigned mPosUVColorLayerVAO = 0;
+	unsigned mSpriteVAO = 0;
+	unsigned mQuadEBO = 0;
+	unsigned mWideQuadEBO = 0;
 };
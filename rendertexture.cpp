@@ -0,0 +1,77 @@
+#include <iostream>
+
+#include <GL/glew.h>
+
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "rendertexture.hpp"
+
+RenderTexture::RenderTexture()
+	: mTexture()
+	, mFramebuffer(0)
+{
+}
+
+bool
+RenderTexture::create(unsigned width, unsigned height, bool smooth)
+{
+	if (!mTexture.create(width, height, nullptr, false, smooth))
+	{
+		return false;
+	}
+
+	if (mFramebuffer == 0)
+	{
+		glCheck(glGenFramebuffers(1, &mFramebuffer));
+	}
+
+	// NOTE: keep the binding of the caller
+	GLint previous;
+	glCheck(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous));
+	GLState::bindFramebuffer(mFramebuffer);
+	glCheck(glFramebufferTexture2D(
+		        GL_FRAMEBUFFER,
+		        GL_COLOR_ATTACHMENT0,
+		        GL_TEXTURE_2D,
+		        mTexture.getNativeHandle(),
+		        0));
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	GLState::bindFramebuffer(previous);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "RenderTexture::create() - Incomplete framebuffer ("
+		          << status << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void
+RenderTexture::destroy() noexcept
+{
+	if (mFramebuffer)
+	{
+		GLState::forgetFramebuffer(mFramebuffer);
+		glCheck(glDeleteFramebuffers(1, &mFramebuffer));
+		mFramebuffer = 0;
+	}
+	mTexture.destroy();
+}
+
+const Texture &
+RenderTexture::getTexture() const
+{
+	return mTexture;
+}
+
+glm::ivec2
+RenderTexture::getSize() const
+{
+	return glm::ivec2(mTexture.getWidth(), mTexture.getHeight());
+}
+
+unsigned
+RenderTexture::getNativeHandle() const
+{
+	return mFramebuffer;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "texture.hpp"
+
+/**
+ * Offscreen target backed by a framebuffer object.
+ *
+ * Pass it to RenderTarget::setRenderTexture() to draw into it with
+ * the usual API, then draw getTexture() like any other texture.
+ */
+class RenderTexture
+{
+public:
+	RenderTexture();
+
+	RenderTexture(const RenderTexture &) = delete;
+	RenderTexture& operator=(const RenderTexture &) = delete;
+	RenderTexture(RenderTexture &&) noexcept = delete;
+	RenderTexture& operator=(RenderTexture &&) noexcept = delete;
+
+	bool create(unsigned width, unsigned height, bool smooth = false);
+	void destroy() noexcept;
+
+	const Texture &getTexture() const;
+	glm::ivec2 getSize() const;
+
+	unsigned getNativeHandle() const;
+
+private:
+	Texture  mTexture;
+	unsigned mFramebuffer;
+};
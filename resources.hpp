@@ -14,10 +14,22 @@ enum class StateID
 enum class TextureID
 {
 	TitleScreen,
-	Explosion,
-	// world textures
-	Entities,
-	Desert,
+};
+
+// NOTE: the draw calls in the same layer may be reordered
+enum RenderLayer
+{
+	LAYER_BACKGROUND,
+	LAYER_ENTITIES,
+	LAYER_EFFECTS,
+	LAYER_OVERLAY,
+	LAYER_TEXT,
+};
+
+// NOTE: layers of the sprites texture array
+enum SpriteLayer
+{
+	SPRITES_ATLAS,
 };
 
 enum class FontID
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <glm/glm.hpp>
+
+#include "s3tc.hpp"
+#include "stb_image.h"
+
+namespace
+{
+const char CACHE_MAGIC[4] = { 'S', '3', 'T', 'C' };
+const std::uint32_t CACHE_VERSION = 1;
+const std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const std::uint64_t FNV_PRIME = 1099511628211ULL;
+const unsigned BLOCK_SIZE = 4;
+const unsigned BLOCK_TEXELS = BLOCK_SIZE * BLOCK_SIZE;
+const unsigned POWER_ITERATIONS = 4;
+
+using Block = std::array<glm::vec4, BLOCK_TEXELS>;
+
+static std::uint16_t
+pack565(const glm::vec3 &color)
+{
+	const auto c = glm::clamp(color, glm::vec3(0.f), glm::vec3(255.f));
+	const auto r = static_cast<std::uint16_t>(c.r * 31.f / 255.f + 0.5f);
+	const auto g = static_cast<std::uint16_t>(c.g * 63.f / 255.f + 0.5f);
+	const auto b = static_cast<std::uint16_t>(c.b * 31.f / 255.f + 0.5f);
+	return r << 11 | g << 5 | b;
+}
+
+static glm::vec3
+unpack565(std::uint16_t color)
+{
+	const unsigned r = color >> 11;
+	const unsigned g = (color >> 5) & 0x3F;
+	const unsigned b = color & 0x1F;
+	return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+static void
+writeColorBlock(const Block &block, std::uint8_t *out)
+{
+	// NOTE: the endpoints are the texels at the ends of the
+	// principal axis of the colors, found by power iteration
+	glm::vec3 mean(0.f);
+	for (const auto &texel : block)
+	{
+		mean += glm::vec3(texel);
+	}
+	mean /= static_cast<float>(BLOCK_TEXELS);
+
+	float cov[6] = {};
+	for (const auto &texel : block)
+	{
+		const auto d = glm::vec3(texel) - mean;
+		cov[0] += d.r * d.r;
+		cov[1] += d.r * d.g;
+		cov[2] += d.r * d.b;
+		cov[3] += d.g * d.g;
+		cov[4] += d.g * d.b;
+		cov[5] += d.b * d.b;
+	}
+	glm::vec3 axis(1.f);
+	for (unsigned i = 0; i < POWER_ITERATIONS; ++i)
+	{
+		axis = glm::vec3(
+			cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+			cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+			cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b);
+		const float norm = std::max({ std::abs(axis.r), std::abs(axis.g), std::abs(axis.b) });
+		axis = norm > 0.f ? axis / norm : glm::vec3(1.f);
+	}
+
+	glm::vec3 minColor(block[0]), maxColor(block[0]);
+	float minDot = glm::dot(minColor, axis), maxDot = minDot;
+	for (const auto &texel : block)
+	{
+		const float d = glm::dot(glm::vec3(texel), axis);
+		if (d < minDot)
+		{
+			minDot = d;
+			minColor = glm::vec3(texel);
+		}
+		if (d > maxDot)
+		{
+			maxDot = d;
+			maxColor = glm::vec3(texel);
+		}
+	}
+
+	// NOTE: color0 > color1 selects the four colors mode, equal
+	// endpoints select the three colors one where only the index 0
+	// is safe to use
+	auto color0 = pack565(maxColor);
+	auto color1 = pack565(minColor);
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+	}
+
+	std::uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		const auto c0 = unpack565(color0);
+		const auto c1 = unpack565(color1);
+		const glm::vec3 palette[4] = {
+			c0,
+			c1,
+			(c0 * 2.f + c1) / 3.f,
+			(c0 + c1 * 2.f) / 3.f,
+		};
+		for (unsigned i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			unsigned best = 0;
+			float bestDistance = -1.f;
+			for (unsigned j = 0; j < 4; ++j)
+			{
+				const auto d = glm::vec3(block[i]) - palette[j];
+				const float distance = glm::dot(d, d);
+				if (bestDistance < 0.f || distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = j;
+				}
+			}
+			indices |= best << (2 * i);
+		}
+	}
+
+	out[0] = color0 & 0xFF;
+	out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF;
+	out[3] = color1 >> 8;
+	for (unsigned i = 0; i < 4; ++i)
+	{
+		out[4 + i] = (indices >> (8 * i)) & 0xFF;
+	}
+}
+
+static void
+writeAlphaBlock(const Block &block, std::uint8_t *out)
+{
+	float minAlpha = block[0].a, maxAlpha = block[0].a;
+	for (const auto &texel : block)
+	{
+		minAlpha = std::min(minAlpha, texel.a);
+		maxAlpha = std::max(maxAlpha, texel.a);
+	}
+
+	// NOTE: alpha0 > alpha1 selects the eight alphas mode
+	const auto alpha0 = static_cast<std::uint8_t>(maxAlpha);
+	const auto alpha1 = static_cast<std::uint8_t>(minAlpha);
+	std::uint64_t indices = 0;
+	if (alpha0 != alpha1)
+	{
+		float palette[8] = { static_cast<float>(alpha0), static_cast<float>(alpha1) };
+		for (unsigned j = 2; j < 8; ++j)
+		{
+			palette[j] = ((8 - j) * palette[0] + (j - 1) * palette[1]) / 7.f;
+		}
+		for (unsigned i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			unsigned best = 0;
+			for (unsigned j = 1; j < 8; ++j)
+			{
+				if (std::abs(block[i].a - palette[j]) < std::abs(block[i].a - palette[best]))
+				{
+					best = j;
+				}
+			}
+			indices |= static_cast<std::uint64_t>(best) << (3 * i);
+		}
+	}
+
+	out[0] = alpha0;
+	out[1] = alpha1;
+	for (unsigned i = 0; i < 6; ++i)
+	{
+		out[2 + i] = (indices >> (8 * i)) & 0xFF;
+	}
+}
+
+static bool
+hashFile(const std::filesystem::path &path, std::uint64_t &hash)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		return false;
+	}
+
+	// NOTE: 64 bits FNV-1a of the contents, the timestamps do not
+	// survive a checkout
+	hash = FNV_OFFSET;
+	std::for_each(std::istreambuf_iterator<char>(in),
+	              std::istreambuf_iterator<char>(),
+	              [&hash](char c) {
+		              hash = (hash ^ static_cast<std::uint8_t>(c)) * FNV_PRIME;
+	              });
+	return true;
+}
+
+template <typename T>
+static void
+writeValue(std::ostream &out, T value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static T
+readValue(std::istream &in)
+{
+	T value{};
+	in.read(reinterpret_cast<char*>(&value), sizeof(value));
+	return value;
+}
+
+static bool
+readCache(const std::filesystem::path &cache, std::uint64_t hash,
+          TextureCompression format, CompressedImage &image)
+{
+	std::ifstream in(cache, std::ios::binary);
+	if (!in)
+	{
+		return false;
+	}
+
+	char magic[sizeof(CACHE_MAGIC)];
+	in.read(magic, sizeof(magic));
+	if (!in || !std::equal(std::begin(magic), std::end(magic), CACHE_MAGIC)
+	    || readValue<std::uint32_t>(in) != CACHE_VERSION
+	    || readValue<std::uint64_t>(in) != hash)
+	{
+		return false;
+	}
+
+	const auto cached = static_cast<TextureCompression>(readValue<std::uint32_t>(in));
+	if ((cached != TextureCompression::BC1 && cached != TextureCompression::BC3)
+	    || (format != TextureCompression::Auto && format != cached))
+	{
+		return false;
+	}
+	image.format = cached;
+	image.width = readValue<std::uint32_t>(in);
+	image.height = readValue<std::uint32_t>(in);
+	image.blocks.resize(S3TC::getRowPitch(image.format, image.width)
+	                    * S3TC::getBlockRows(image.height));
+	in.read(reinterpret_cast<char*>(image.blocks.data()), image.blocks.size());
+	return in.good();
+}
+
+static bool
+writeCache(const std::filesystem::path &cache, std::uint64_t hash,
+           const CompressedImage &image)
+{
+	// NOTE: the cache is local to the machine, the values are
+	// written in the host byte order
+	std::ofstream out(cache, std::ios::binary);
+	out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writeValue<std::uint32_t>(out, CACHE_VERSION);
+	writeValue<std::uint64_t>(out, hash);
+	writeValue<std::uint32_t>(out, static_cast<std::uint32_t>(image.format));
+	writeValue<std::uint32_t>(out, image.width);
+	writeValue<std::uint32_t>(out, image.height);
+	out.write(reinterpret_cast<const char*>(image.blocks.data()), image.blocks.size());
+	if (!out)
+	{
+		std::cerr << "S3TC::saveToCache() - Unable to write "
+		          << cache.string() << std::endl;
+		return false;
+	}
+	return true;
+}
+}
+
+namespace S3TC
+{
+std::size_t
+getRowPitch(TextureCompression format, unsigned width)
+{
+	const std::size_t blockBytes = format == TextureCompression::BC1 ? 8 : 16;
+	return (width + BLOCK_SIZE - 1) / BLOCK_SIZE * blockBytes;
+}
+
+unsigned
+getBlockRows(unsigned height)
+{
+	return (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+void
+compress(const std::uint8_t *pixels, unsigned width, unsigned height,
+         TextureCompression format, CompressedImage &image)
+{
+	if (format == TextureCompression::Auto || format == TextureCompression::None)
+	{
+		format = TextureCompression::BC1;
+		for (std::size_t i = 3; i < std::size_t(width) * height * 4; i += 4)
+		{
+			if (pixels[i] != 0xFF)
+			{
+				format = TextureCompression::BC3;
+				break;
+			}
+		}
+	}
+
+	image.format = format;
+	image.width = width;
+	image.height = height;
+	const auto pitch = getRowPitch(format, width);
+	image.blocks.resize(pitch * getBlockRows(height));
+
+	Block block;
+	auto *out = image.blocks.data();
+	for (unsigned by = 0; by < height; by += BLOCK_SIZE)
+	{
+		for (unsigned bx = 0; bx < width; bx += BLOCK_SIZE)
+		{
+			for (unsigned i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				const unsigned x = std::min(bx + i % BLOCK_SIZE, width - 1);
+				const unsigned y = std::min(by + i / BLOCK_SIZE, height - 1);
+				const auto *texel = pixels + (std::size_t(y) * width + x) * 4;
+				block[i] = glm::vec4(texel[0], texel[1], texel[2], texel[3]);
+			}
+			if (format == TextureCompression::BC3)
+			{
+				writeAlphaBlock(block, out);
+				out += 8;
+			}
+			writeColorBlock(block, out);
+			out += 8;
+		}
+	}
+}
+
+std::filesystem::path
+getCachePath(const std::filesystem::path &source)
+{
+	auto path = source;
+	path += ".s3tc";
+	return path;
+}
+
+bool
+loadFromCache(const std::filesystem::path &source,
+              TextureCompression format, CompressedImage &image)
+{
+	std::uint64_t hash;
+	return hashFile(source, hash)
+		&& readCache(getCachePath(source), hash, format, image);
+}
+
+bool
+saveToCache(const std::filesystem::path &source, const CompressedImage &image)
+{
+	std::uint64_t hash;
+	if (!hashFile(source, hash))
+	{
+		std::cerr << "S3TC::saveToCache() - Unable to read "
+		          << source.string() << std::endl;
+		return false;
+	}
+	return writeCache(getCachePath(source), hash, image);
+}
+
+bool
+load(const std::filesystem::path &source,
+     TextureCompression format, CompressedImage &image)
+{
+	std::uint64_t hash;
+	if (!hashFile(source, hash))
+	{
+		std::cerr << "S3TC::load() - Unable to read "
+		          << source.string() << std::endl;
+		return false;
+	}
+
+	const auto cache = getCachePath(source);
+	if (readCache(cache, hash, format, image))
+	{
+		return true;
+	}
+
+	int width, height, channels;
+	auto *pixels = stbi_load(source.c_str(), &width, &height, &channels, 4);
+	if (pixels == nullptr)
+	{
+		std::cerr << "S3TC::load() - Unable to load "
+		          << source.string() << std::endl;
+		return false;
+	}
+	compress(pixels, width, height, format, image);
+	stbi_image_free(pixels);
+
+	// NOTE: the next runs skip the compression
+	writeCache(cache, hash, image);
+	return true;
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/**
+ * Block compression of the textures: BC1 (DXT1) stores 4x4 opaque
+ * texels in 8 bytes, BC3 (DXT5) adds 8 bytes of alpha for 16 bytes
+ * per block. Auto picks BC1 for the opaque images and BC3 otherwise.
+ */
+enum class TextureCompression
+{
+	None,
+	Auto,
+	BC1,
+	BC3,
+};
+
+/**
+ * Rows of 4x4 blocks from top to bottom, the blocks past the right
+ * and bottom edges repeat the last column and row of texels.
+ */
+struct CompressedImage
+{
+	TextureCompression format = TextureCompression::None;
+	unsigned width = 0;
+	unsigned height = 0;
+	std::vector<std::uint8_t> blocks;
+};
+
+namespace S3TC
+{
+/**
+ * Get the bytes of a row of blocks of an image @width texels wide.
+ */
+std::size_t getRowPitch(TextureCompression format, unsigned width);
+
+/**
+ * Get the rows of blocks of an image @height texels high.
+ */
+unsigned getBlockRows(unsigned height);
+
+/**
+ * Compress the RGBA @pixels in the given @format.
+ */
+void compress(const std::uint8_t *pixels, unsigned width, unsigned height,
+              TextureCompression format, CompressedImage &image);
+
+/**
+ * Get the cache of the @source image, stored next to it.
+ */
+std::filesystem::path getCachePath(const std::filesystem::path &source);
+
+/**
+ * Load the cache of the @source image, it is rejected when it was
+ * made from different contents or in another @format.
+ */
+bool loadFromCache(const std::filesystem::path &source,
+                   TextureCompression format, CompressedImage &image);
+
+bool saveToCache(const std::filesystem::path &source, const CompressedImage &image);
+
+/**
+ * Load the cache of the @source image or compress the image and
+ * write the cache, a cache which cannot be written is not an error.
+ */
+bool load(const std::filesystem::path &source,
+          TextureCompression format, CompressedImage &image);
+}
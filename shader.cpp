@@ -4,6 +4,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "glcheck.hpp"
+#include "glstate.hpp"
 #include "shader.hpp"
 #include "utility.hpp"
 
@@ -113,6 +114,7 @@ Shader::destroy()
 {
 	if (mProgram)
 	{
+		GLState::forgetProgram(mProgram);
 		glCheck(glDeleteProgram(mProgram));
 	}
 }
@@ -160,6 +162,15 @@ Shader::attachFile(ShaderType shaderType, const std::filesystem::path &filename)
 	attachString(shaderType, Utility::loadFile(filename));
 }
 
+void
+Shader::setFeedbackVaryings(std::initializer_list<const char*> varyings) const
+{
+	glCheck(glTransformFeedbackVaryings(mProgram,
+	                                    varyings.size(),
+	                                    varyings.begin(),
+	                                    GL_INTERLEAVED_ATTRIBS));
+}
+
 void
 Shader::link() const
 {
@@ -180,7 +191,7 @@ Shader::link() const
 void
 Shader::use() const noexcept
 {
-	glCheck(glUseProgram(mProgram));
+	GLState::useProgram(mProgram);
 }
 
 ShaderUniform
@@ -193,3 +204,14 @@ Shader::getUniform(const std::string &name) const
 	}
 	return ShaderUniform(location);
 }
+
+void
+Shader::bindUniformBlock(const std::string &name, unsigned binding) const
+{
+	auto index = glGetUniformBlockIndex(mProgram, name.c_str());
+	if (index == GL_INVALID_INDEX)
+	{
+		throw std::runtime_error(name + " uniform block not found");
+	}
+	glCheck(glUniformBlockBinding(mProgram, index, binding));
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <filesystem>
+#include <initializer_list>
 #include <string>
 
 #include <glm/glm.hpp>
@@ -52,11 +53,22 @@ public:
 
 	void attachString(ShaderType type, const std::string &source) const;
 	void attachFile(ShaderType type, const std::filesystem::path &filename) const;
+	/**
+	 * Capture the @varyings interleaved in a single buffer when the
+	 * program runs with transform feedback, call it before link().
+	 */
+	void setFeedbackVaryings(std::initializer_list<const char*> varyings) const;
 	void link() const;
 
 	void use() const noexcept;
 
 	ShaderUniform getUniform(const std::string &name) const;
+
+	/**
+	 * Read the uniform block @name from the buffer bound at the
+	 * @binding point.
+	 */
+	void bindUniformBlock(const std::string &name, unsigned binding) const;
 private:
 	void checkCompilation();
 	void checkLink();
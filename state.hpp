@@ -16,4 +16,10 @@ public:
 	virtual bool update(float dt) = 0;
 	virtual bool handleEvent(const Event &event) = 0;
 	virtual void draw(RenderTarget &target) = 0;
+
+	/**
+	 * Opaque states cover the whole screen, the states below them
+	 * are not drawn.
+	 */
+	virtual bool isOpaque() const { return false; }
 };
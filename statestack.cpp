@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 
 #include "state.hpp"
@@ -48,9 +49,35 @@ StateStack::handleEvent(const Event &event)
 void
 StateStack::draw(RenderTarget &target)
 {
-	for (auto &state: mStack)
+	draw(mStack.end(), target);
+}
+
+void
+StateStack::drawBelow(const State &state, RenderTarget &target)
+{
+	auto it = std::find_if(mStack.begin(), mStack.end(), [&](const auto &ptr) {
+		return ptr.get() == &state;
+	});
+	assert(it != mStack.end() && "State not in the stack");
+	draw(it, target);
+}
+
+void
+StateStack::draw(std::vector<State::Ptr>::iterator end, RenderTarget &target)
+{
+	// NOTE: start from the topmost opaque state
+	auto begin = end;
+	while (begin != mStack.begin())
+	{
+		--begin;
+		if ((*begin)->isOpaque())
+		{
+			break;
+		}
+	}
+	for (auto it = begin; it != end; ++it)
 	{
-		state->draw(target);
+		(*it)->draw(target);
 	}
 }
 
@@ -22,15 +22,21 @@ public:
 	bool handleEvent(const Event &event);
 	void draw(RenderTarget &target);
 
+	/**
+	 * Draw the states below @state, as draw() would do.
+	 */
+	void drawBelow(const State &state, RenderTarget &target);
+
 	void pushState(StateID state);
 	void popState();
 	void clearStack();
 
 	bool isEmpty() const;
+	void applyPendingChanges();
 
 private:
 	State::Ptr createState(StateID state);
-	void applyPendingChanges();
+	void draw(std::vector<State::Ptr>::iterator end, RenderTarget &target);
 
 private:
 	enum Action
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include <GL/glew.h>
+
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "streambuffer.hpp"
+
+namespace
+{
+const GLuint64 FENCE_TIMEOUT = 1000000000ULL;
+
+static inline std::size_t
+alignUp(std::size_t value, std::size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+StreamBuffer::StreamBuffer()
+	: mFences{}
+	, mWritten{}
+	, mPersistent(nullptr)
+	, mRegionSize(0)
+	, mHead(0)
+	, mMapOffset(0)
+	, mRegion(0)
+	, mTarget(0)
+	, mBuffer(0)
+{
+}
+
+bool
+StreamBuffer::create(unsigned target, std::size_t regionSize)
+{
+	mTarget = target;
+	mWritten.fill(false);
+	mRegionSize = regionSize;
+	mHead = mMapOffset = 0;
+	mRegion = 0;
+
+	const auto size = static_cast<GLsizeiptr>(mRegionSize * RegionCount);
+	glCheck(glGenBuffers(1, &mBuffer));
+	GLState::bindBuffer(mTarget, mBuffer);
+	if (GLEW_ARB_buffer_storage)
+	{
+		// NOTE: the buffer stays mapped for its whole lifetime
+		const GLbitfield flags = GL_MAP_WRITE_BIT
+			| GL_MAP_PERSISTENT_BIT
+			| GL_MAP_COHERENT_BIT;
+		glCheck(glBufferStorage(mTarget, size, nullptr, flags));
+		mPersistent = static_cast<std::byte*>(
+			glMapBufferRange(mTarget, 0, size, flags));
+		if (mPersistent == nullptr)
+		{
+			throw std::runtime_error("StreamBuffer::create() - "
+			                         "unable to map the buffer");
+		}
+	}
+	else
+	{
+		glCheck(glBufferData(mTarget, size, nullptr, GL_STREAM_DRAW));
+	}
+	return true;
+}
+
+void
+StreamBuffer::destroy()
+{
+	for (auto &fence : mFences)
+	{
+		if (fence)
+		{
+			glCheck(glDeleteSync(static_cast<GLsync>(fence)));
+			fence = nullptr;
+		}
+	}
+	if (mBuffer)
+	{
+		if (mPersistent)
+		{
+			GLState::bindBuffer(mTarget, mBuffer);
+			glCheck(glUnmapBuffer(mTarget));
+			mPersistent = nullptr;
+		}
+		GLState::forgetBuffer(mBuffer);
+		glCheck(glDeleteBuffers(1, &mBuffer));
+		mBuffer = 0;
+	}
+}
+
+void *
+StreamBuffer::map(std::size_t size, std::size_t alignment)
+{
+	assert(size <= mRegionSize && "Mapping bigger than a region");
+
+	auto offset = alignUp(mHead, alignment);
+	if (offset + size > (mRegion + 1) * mRegionSize)
+	{
+		nextRegion();
+		offset = alignUp(mHead, alignment);
+		assert(offset + size <= (mRegion + 1) * mRegionSize
+		       && "Aligned mapping bigger than a region");
+	}
+	mMapOffset = offset;
+	mWritten[mRegion] = true;
+
+	if (mPersistent)
+	{
+		return mPersistent + offset;
+	}
+
+	// NOTE: the fences guarantee that the GPU is done with the range
+	const GLbitfield flags = GL_MAP_WRITE_BIT
+		| GL_MAP_UNSYNCHRONIZED_BIT
+		| GL_MAP_INVALIDATE_RANGE_BIT
+		| GL_MAP_FLUSH_EXPLICIT_BIT;
+	GLState::bindBuffer(mTarget, mBuffer);
+	void *ptr = glMapBufferRange(mTarget, offset, size, flags);
+	if (ptr == nullptr)
+	{
+		throw std::runtime_error("StreamBuffer::map() - "
+		                         "unable to map the buffer");
+	}
+	return ptr;
+}
+
+void
+StreamBuffer::unmap(std::size_t size)
+{
+	if (!mPersistent)
+	{
+		GLState::bindBuffer(mTarget, mBuffer);
+		if (size)
+		{
+			glCheck(glFlushMappedBufferRange(mTarget, 0, size));
+		}
+		glCheck(glUnmapBuffer(mTarget));
+	}
+	mHead = mMapOffset + size;
+}
+
+void
+StreamBuffer::fence()
+{
+	for (unsigned i = 0; i < RegionCount; ++i)
+	{
+		if (!mWritten[i])
+		{
+			continue;
+		}
+		if (mFences[i])
+		{
+			glCheck(glDeleteSync(static_cast<GLsync>(mFences[i])));
+		}
+		mFences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		mWritten[i] = false;
+	}
+}
+
+unsigned
+StreamBuffer::getPendingRegions() const
+{
+	return std::count(mWritten.begin(), mWritten.end(), true);
+}
+
+std::size_t
+StreamBuffer::getOffset() const
+{
+	return mMapOffset;
+}
+
+std::size_t
+StreamBuffer::getRemaining() const
+{
+	return (mRegion + 1) * mRegionSize - mHead;
+}
+
+std::size_t
+StreamBuffer::getRegionSize() const
+{
+	return mRegionSize;
+}
+
+unsigned
+StreamBuffer::getNativeHandle() const
+{
+	return mBuffer;
+}
+
+void
+StreamBuffer::nextRegion()
+{
+	// NOTE: the region we are leaving is protected by the next
+	// fence(), after the commands which read it are submitted
+	mRegion = (mRegion + 1) % RegionCount;
+	assert(!mWritten[mRegion] && "Region written again before fence()");
+
+	// wait until the GPU has consumed the next one
+	if (auto fence = static_cast<GLsync>(mFences[mRegion]); fence)
+	{
+		GLenum status;
+		do
+		{
+			status = glClientWaitSync(fence,
+			                          GL_SYNC_FLUSH_COMMANDS_BIT,
+			                          FENCE_TIMEOUT);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		glCheck(glDeleteSync(fence));
+		mFences[mRegion] = nullptr;
+	}
+	mHead = mRegion * mRegionSize;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Ring buffer used to stream vertex data to the GPU.
+ *
+ * The buffer is split in RegionCount regions, each one guarded by a
+ * fence: a region is written again only after the GPU has consumed
+ * the commands that used it. The owner calls fence() once those
+ * commands have been submitted and must not write more than
+ * RegionCount regions between two calls. When ARB_buffer_storage is available
+ * the buffer is mapped once and persistently, otherwise every map()
+ * falls back to an unsynchronized glMapBufferRange().
+ */
+class StreamBuffer
+{
+public:
+	static constexpr unsigned RegionCount = 3;
+
+	StreamBuffer();
+
+	StreamBuffer(const StreamBuffer &) = delete;
+	StreamBuffer& operator=(const StreamBuffer &) = delete;
+	StreamBuffer(StreamBuffer &&) noexcept = delete;
+	StreamBuffer& operator=(StreamBuffer &&) noexcept = delete;
+
+	/**
+	 * Create the buffer with the given @target (GL_ARRAY_BUFFER,
+	 * GL_ELEMENT_ARRAY_BUFFER or GL_PIXEL_UNPACK_BUFFER) and a size
+	 * of @regionSize bytes for each region.
+	 */
+	bool create(unsigned target, std::size_t regionSize);
+	void destroy();
+
+	/**
+	 * Map at most @size bytes of the buffer for writing, starting
+	 * from an offset multiple of @alignment.
+	 * @return a pointer to the mapped memory
+	 */
+	void *map(std::size_t size, std::size_t alignment);
+
+	/**
+	 * Unmap the buffer and commit the first @size bytes written
+	 * after the last call to map().
+	 */
+	void unmap(std::size_t size);
+
+	/**
+	 * Protect the regions written since the last call until the GPU
+	 * has consumed the commands submitted so far.
+	 */
+	void fence();
+
+	/**
+	 * Get the number of regions written since the last fence(), the
+	 * next region is still in use when it is RegionCount.
+	 */
+	unsigned getPendingRegions() const;
+
+	/**
+	 * Get the offset in bytes of the last mapped range.
+	 */
+	std::size_t getOffset() const;
+
+	/**
+	 * Get the bytes left in the current region, a bigger map()
+	 * moves to the next one.
+	 */
+	std::size_t getRemaining() const;
+
+	std::size_t getRegionSize() const;
+	unsigned getNativeHandle() const;
+
+private:
+	void nextRegion();
+
+private:
+	std::array<void*, RegionCount> mFences;
+	std::array<bool, RegionCount>  mWritten;
+	std::byte   *mPersistent;
+	std::size_t  mRegionSize;
+	std::size_t  mHead;
+	std::size_t  mMapOffset;
+	unsigned     mRegion;
+	unsigned     mTarget;
+	unsigned     mBuffer;
+};
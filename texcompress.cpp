@@ -0,0 +1,24 @@
+#include <iostream>
+
+#include "s3tc.hpp"
+
+int
+main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <image>..." << std::endl;
+		return 1;
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		// NOTE: the cache is rewritten only when the image changed
+		CompressedImage image;
+		if (!S3TC::load(argv[i], TextureCompression::Auto, image))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <codecvt>
+#include <cstddef>
+#include <locale>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "font.hpp"
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "quad.hpp"
+#include "text.hpp"
+
+Text::Text()
+	: mString()
+	, mFont(nullptr)
+	, mColor(Color::White)
+	, mPosition(0.f)
+	, mSize(0.f)
+	, mNeedsUpdate(true)
+	, mNeedsUpload(true)
+	, mGeneration(0)
+	, mQuadCount(0)
+	, mTexture(0)
+	, mVertices()
+	, mBuffer(nullptr)
+	, mFirst(0)
+	, mCapacity(0)
+{
+}
+
+void
+Text::destroy()
+{
+	if (mBuffer)
+	{
+		mBuffer->release(mFirst, mCapacity);
+		mBuffer = nullptr;
+		mFirst = mCapacity = 0;
+	}
+	mVertices.clear();
+	mQuadCount = 0;
+	mNeedsUpdate = true;
+}
+
+void
+Text::setString(const std::string &string)
+{
+	if (mString != string)
+	{
+		mString = string;
+		mNeedsUpdate = true;
+	}
+}
+
+const std::string &
+Text::getString() const
+{
+	return mString;
+}
+
+void
+Text::setFont(Font &font)
+{
+	if (mFont != &font)
+	{
+		mFont = &font;
+		mNeedsUpdate = true;
+	}
+}
+
+void
+Text::setColor(Color color)
+{
+	if (static_cast<std::uint32_t>(mColor) != color)
+	{
+		mColor = color;
+		mNeedsUpdate = true;
+	}
+}
+
+void
+Text::setPosition(glm::vec2 position)
+{
+	if (mPosition != position)
+	{
+		mPosition = position;
+		mNeedsUpload = true;
+	}
+}
+
+glm::vec2
+Text::getPosition() const
+{
+	return mPosition;
+}
+
+glm::vec2
+Text::getSize()
+{
+	update();
+	return mSize;
+}
+
+bool
+Text::update()
+{
+	if (mFont == nullptr || mString.empty())
+	{
+		return false;
+	}
+
+	// NOTE: the glyphs move when the font texture grows
+	if (!mNeedsUpdate && mGeneration == mFont->getGeneration())
+	{
+		return mQuadCount > 0;
+	}
+
+	// NOTE: render all the glyphs first, a new one may grow the
+	// texture and move the UVs of the others
+	std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> cv;
+	const auto codepoints = cv.from_bytes(mString);
+	for (auto codepoint : codepoints)
+	{
+		mFont->getGlyph(codepoint);
+	}
+
+	mVertices.clear();
+	mVertices.reserve(codepoints.size() * 4);
+	glm::vec2 pos(0.f, mFont->getLineHeight());
+	mSize = glm::vec2(0.f);
+	for (auto codepoint : codepoints)
+	{
+		const auto &g = mFont->getGlyph(codepoint);
+		const glm::vec2 corner = pos + glm::vec2(g.bearing.x, -g.bearing.y);
+		for (auto unit : Quad::units)
+		{
+			mVertices.push_back(Vertex{
+					unit * g.size + corner,
+					unit * g.uvSize + g.uvPos,
+					mColor,
+				});
+		}
+		mSize.y = std::max(mSize.y, g.size.y + g.bearing.y);
+		pos.x += g.advance;
+	}
+	mSize.x = pos.x;
+
+	mQuadCount = codepoints.size();
+	mTexture = mFont->getTexture().getNativeHandle();
+	mGeneration = mFont->getGeneration();
+	mNeedsUpdate = false;
+	mNeedsUpload = true;
+	return mQuadCount > 0;
+}
+
+unsigned
+Text::commit(TextBuffer &buffer)
+{
+	// NOTE: a shorter string keeps the range, a longer one moves
+	// the text to a new range
+	if (mBuffer != &buffer || mCapacity < mQuadCount)
+	{
+		if (mBuffer)
+		{
+			mBuffer->release(mFirst, mCapacity);
+		}
+		mBuffer = &buffer;
+		mFirst = buffer.allocate(mQuadCount);
+		mCapacity = mQuadCount;
+		mNeedsUpload = true;
+	}
+	if (mNeedsUpload)
+	{
+		buffer.upload(mFirst, mVertices, mPosition);
+		mNeedsUpload = false;
+	}
+	return mFirst * 4;
+}
+
+Font *
+Text::getFont() const
+{
+	return mFont;
+}
+
+unsigned
+Text::getTexture() const
+{
+	return mTexture;
+}
+
+unsigned
+Text::getQuadCount() const
+{
+	return mQuadCount;
+}
+
+TextBuffer::TextBuffer()
+	: mFree()
+	, mScratch()
+	, mCapacity(0)
+	, mVAO(0)
+	, mVBO(0)
+{
+}
+
+void
+TextBuffer::create(unsigned quads)
+{
+	glCheck(glGenVertexArrays(1, &mVAO));
+	grow(quads);
+}
+
+void
+TextBuffer::destroy()
+{
+	if (mVAO)
+	{
+		GLState::forgetVertexArray(mVAO);
+		glCheck(glDeleteVertexArrays(1, &mVAO));
+		GLState::forgetBuffer(mVBO);
+		glCheck(glDeleteBuffers(1, &mVBO));
+		mVAO = mVBO = 0;
+	}
+	mFree.clear();
+	mCapacity = 0;
+}
+
+unsigned
+TextBuffer::allocate(unsigned quads)
+{
+	// NOTE: first fit, the texts are few and rarely change length
+	const auto fits = [quads](const auto &range) {
+		return range.second >= quads;
+	};
+	auto it = std::find_if(mFree.begin(), mFree.end(), fits);
+	if (it == mFree.end())
+	{
+		grow(quads);
+		it = std::find_if(mFree.begin(), mFree.end(), fits);
+	}
+	const unsigned first = it->first;
+	it->first += quads;
+	it->second -= quads;
+	if (it->second == 0)
+	{
+		mFree.erase(it);
+	}
+	return first;
+}
+
+void
+TextBuffer::release(unsigned first, unsigned quads)
+{
+	if (quads == 0)
+	{
+		return;
+	}
+
+	auto it = std::lower_bound(mFree.begin(), mFree.end(), std::make_pair(first, 0u));
+	it = mFree.insert(it, std::make_pair(first, quads));
+	auto next = it + 1;
+	if (next != mFree.end() && it->first + it->second == next->first)
+	{
+		it->second += next->second;
+		mFree.erase(next);
+	}
+	if (it != mFree.begin())
+	{
+		auto prev = it - 1;
+		if (prev->first + prev->second == it->first)
+		{
+			prev->second += it->second;
+			mFree.erase(it);
+		}
+	}
+}
+
+void
+TextBuffer::upload(unsigned first, std::span<const Text::Vertex> vertices, glm::vec2 offset)
+{
+	mScratch.assign(vertices.begin(), vertices.end());
+	for (auto &v : mScratch)
+	{
+		v.pos += offset;
+	}
+	GLState::bindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glCheck(glBufferSubData(GL_ARRAY_BUFFER,
+	                        first * 4 * sizeof(Text::Vertex),
+	                        mScratch.size() * sizeof(Text::Vertex),
+	                        mScratch.data()));
+}
+
+unsigned
+TextBuffer::getVertexArray() const
+{
+	return mVAO;
+}
+
+void
+TextBuffer::grow(unsigned quads)
+{
+	// NOTE: the free range at the end of the buffer is part of the
+	// new range
+	unsigned tail = 0;
+	if (!mFree.empty() && mFree.back().first + mFree.back().second == mCapacity)
+	{
+		tail = mFree.back().second;
+	}
+	const unsigned capacity = std::max(mCapacity * 2, mCapacity - tail + quads);
+
+	unsigned vbo;
+	glCheck(glGenBuffers(1, &vbo));
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+	glCheck(glBufferData(GL_COPY_WRITE_BUFFER,
+	                     capacity * 4 * sizeof(Text::Vertex),
+	                     nullptr,
+	                     GL_DYNAMIC_DRAW));
+	if (mVBO)
+	{
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, mVBO);
+		glCheck(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+		                            0, 0, mCapacity * 4 * sizeof(Text::Vertex)));
+		GLState::forgetBuffer(mVBO);
+		glCheck(glDeleteBuffers(1, &mVBO));
+	}
+	mVBO = vbo;
+	release(mCapacity, capacity - mCapacity);
+	mCapacity = capacity;
+	setLayout();
+}
+
+void
+TextBuffer::setLayout()
+{
+	GLState::bindVertexArray(mVAO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glCheck(glEnableVertexAttribArray(0));
+	glCheck(glVertexAttribPointer(
+		        0, 2, GL_FLOAT, GL_FALSE, sizeof(Text::Vertex),
+		        reinterpret_cast<GLvoid*>(offsetof(Text::Vertex, pos))));
+	glCheck(glEnableVertexAttribArray(1));
+	glCheck(glVertexAttribPointer(
+		        1, 2, GL_FLOAT, GL_FALSE, sizeof(Text::Vertex),
+		        reinterpret_cast<GLvoid*>(offsetof(Text::Vertex, uv))));
+	glCheck(glEnableVertexAttribArray(2));
+	glCheck(glVertexAttribPointer(
+		        2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Text::Vertex),
+		        reinterpret_cast<GLvoid*>(offsetof(Text::Vertex, color))));
+}
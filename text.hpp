@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "color.hpp"
+
+class Font;
+class TextBuffer;
+
+/**
+ * String laid out once in a range of the shared text buffer.
+ *
+ * The glyph quads are built again only when the string, the font,
+ * the color or the generation of the font texture change; moving
+ * the text uploads its vertices again but builds nothing.
+ */
+class Text
+{
+public:
+	struct Vertex
+	{
+		glm::vec2 pos;
+		glm::vec2 uv;
+		std::uint32_t color;
+	};
+
+public:
+	Text();
+
+	Text(const Text &) = delete;
+	Text& operator=(const Text &) = delete;
+	Text(Text &&) noexcept = delete;
+	Text& operator=(Text &&) noexcept = delete;
+
+	void destroy();
+
+	void setString(const std::string &string);
+	const std::string &getString() const;
+
+	void setFont(Font &font);
+	Font *getFont() const;
+	void setColor(Color color);
+
+	void setPosition(glm::vec2 position);
+	glm::vec2 getPosition() const;
+
+	/**
+	 * Get the size of the text, laying it out if needed.
+	 */
+	glm::vec2 getSize();
+
+	/**
+	 * Build the quads again if anything changed since the last call.
+	 * @return false if there is nothing to draw
+	 */
+	bool update();
+
+	/**
+	 * Upload the quads to the @buffer if they changed or moved.
+	 * @return the first vertex of the text in the buffer
+	 */
+	unsigned commit(TextBuffer &buffer);
+
+	unsigned getTexture() const;
+	unsigned getQuadCount() const;
+
+private:
+	std::string mString;
+	Font     *mFont;
+	Color     mColor;
+	glm::vec2 mPosition;
+	glm::vec2 mSize;
+	bool      mNeedsUpdate;
+	bool      mNeedsUpload;
+	unsigned  mGeneration;
+	unsigned  mQuadCount;
+	unsigned  mTexture;
+	std::vector<Vertex> mVertices;
+	TextBuffer *mBuffer;
+	unsigned  mFirst;
+	unsigned  mCapacity;
+};
+
+/**
+ * Vertex buffer shared by all the texts, drawn with the quad
+ * indices of the render target.
+ *
+ * Every text owns a range of quads; the free ranges are kept
+ * sorted and merged when released, the buffer doubles when no
+ * range is large enough.
+ */
+class TextBuffer
+{
+public:
+	TextBuffer();
+
+	TextBuffer(const TextBuffer &) = delete;
+	TextBuffer& operator=(const TextBuffer &) = delete;
+	TextBuffer(TextBuffer &&) noexcept = delete;
+	TextBuffer& operator=(TextBuffer &&) noexcept = delete;
+
+	void create(unsigned quads);
+	void destroy();
+
+	/**
+	 * Allocate a range of @quads quads.
+	 * @return the first quad of the range
+	 */
+	unsigned allocate(unsigned quads);
+	void release(unsigned first, unsigned quads);
+
+	/**
+	 * Write the @vertices moved by @offset starting at the @first quad.
+	 */
+	void upload(unsigned first, std::span<const Text::Vertex> vertices, glm::vec2 offset);
+
+	unsigned getVertexArray() const;
+
+private:
+	void grow(unsigned quads);
+	void setLayout();
+
+private:
+	std::vector<std::pair<unsigned, unsigned>> mFree;
+	std::vector<Text::Vertex> mScratch;
+	unsigned mCapacity;
+	unsigned mVAO;
+	unsigned mVBO;
+};
@@ -1,20 +1,82 @@
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <iostream>
 
 #include <GL/glew.h>
 
 #include "glcheck.hpp"
+#include "glstate.hpp"
 #include "texture.hpp"
 #include "stb_image.h"
 
+namespace
+{
+const std::size_t BYTES_PER_PIXEL = 4;
+
+static inline int
+area(const IntRect &rect)
+{
+	return rect.size.x * rect.size.y;
+}
+
+static inline IntRect
+unite(const IntRect &a, const IntRect &b)
+{
+	const auto topLeft = glm::min(a.pos, b.pos);
+	const auto bottomRight = glm::max(a.pos + a.size, b.pos + b.size);
+	return IntRect(topLeft, bottomRight - topLeft);
+}
+
+static inline GLint
+getMinFilter(bool smooth, unsigned levels)
+{
+	if (levels > 1)
+	{
+		return smooth ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR;
+	}
+	return smooth ? GL_LINEAR : GL_NEAREST;
+}
+
+static inline GLenum
+getCompressedFormat(TextureCompression format)
+{
+	return format == TextureCompression::BC1
+		? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		: GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+static inline bool
+touches(const IntRect &a, const IntRect &b)
+{
+	return a.pos.x <= b.pos.x + b.size.x && b.pos.x <= a.pos.x + a.size.x
+		&& a.pos.y <= b.pos.y + b.size.y && b.pos.y <= a.pos.y + a.size.y;
+}
+}
+
 Texture::Texture()
-	: mTexture(-1U)
+	: mDescriptor()
+	, mStaging()
+	, mDirtyRects()
+	, mNeedsReadback(false)
+	, mTexture(-1U)
 {
 }
 
 bool
-Texture::loadFromFile(const std::filesystem::path &path)
+Texture::loadFromFile(const std::filesystem::path &path, TextureCompression compression)
 {
+	// NOTE: a source which cannot be compressed is still loaded
+	if (compression != TextureCompression::None && isCompressionAvailable())
+	{
+		CompressedImage image;
+		if (S3TC::load(path, compression, image)
+		    && create(image.width, image.height, image.format, image.blocks.data()))
+		{
+			return true;
+		}
+	}
+
 	int width, height, channels;
 	auto *pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
 	if (pixels == nullptr)
@@ -48,7 +110,7 @@ Texture::create(unsigned width, unsigned height, const void *pixels, bool repeat
 	{
 		glCheck(glGenTextures(1, &mTexture));
 	}
-	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	GLState::bindTexture(GL_TEXTURE_2D, mTexture);
 	glCheck(glTexImage2D(
 		        GL_TEXTURE_2D,
 		        0,
@@ -59,7 +121,84 @@ Texture::create(unsigned width, unsigned height, const void *pixels, bool repeat
 		        GL_RGBA,
 		        GL_UNSIGNED_BYTE,
 		        pixels));
+	setParameters(width, height, GL_RGBA, repeat, smooth);
+	mNeedsReadback = pixels != nullptr;
+	return true;
+}
+
+bool
+Texture::create(unsigned width, unsigned height, TextureCompression format,
+                const void *blocks, bool repeat, bool smooth)
+{
+	assert((format == TextureCompression::BC1 || format == TextureCompression::BC3)
+	       && "Not a compressed format");
+	if (width == 0 || height == 0)
+	{
+		std::cerr << "Texture::create() - Invalid texture size ("
+		          << width << ", " << height << ")" << std::endl;
+		return false;
+	}
+	if (!isCompressionAvailable())
+	{
+		std::cerr << "Texture::create() - S3TC not supported" << std::endl;
+		return false;
+	}
+
+	if (mTexture == -1U)
+	{
+		glCheck(glGenTextures(1, &mTexture));
+	}
+	GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+	const GLenum internalFormat = getCompressedFormat(format);
+	if (blocks)
+	{
+		const auto size = S3TC::getRowPitch(format, width) * S3TC::getBlockRows(height);
+		glCheck(glCompressedTexImage2D(
+			        GL_TEXTURE_2D,
+			        0,
+			        internalFormat,
+			        static_cast<GLsizei>(width),
+			        static_cast<GLsizei>(height),
+			        0,
+			        static_cast<GLsizei>(size),
+			        blocks));
+	}
+	else
+	{
+		// NOTE: S3TC allows the compressed formats in glTexImage2D()
+		// to allocate the storage
+		glCheck(glTexImage2D(
+			        GL_TEXTURE_2D,
+			        0,
+			        internalFormat,
+			        static_cast<GLsizei>(width),
+			        static_cast<GLsizei>(height),
+			        0,
+			        GL_RGBA,
+			        GL_UNSIGNED_BYTE,
+			        nullptr));
+	}
+	setParameters(width, height, internalFormat, repeat, smooth);
+	return true;
+}
 
+bool
+Texture::isCompressed() const
+{
+	return mDescriptor.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		|| mDescriptor.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+bool
+Texture::isCompressionAvailable()
+{
+	return GLEW_EXT_texture_compression_s3tc;
+}
+
+void
+Texture::setParameters(unsigned width, unsigned height, unsigned format,
+                       bool repeat, bool smooth)
+{
 	GLint parameter = repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, parameter));
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, parameter));
@@ -67,8 +206,22 @@ Texture::create(unsigned width, unsigned height, const void *pixels, bool repeat
 	parameter = smooth ? GL_LINEAR : GL_NEAREST;
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, parameter));
 	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, parameter));
+	if (mDescriptor.anisotropy != 1.f && GLEW_EXT_texture_filter_anisotropic)
+	{
+		glCheck(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.f));
+	}
 
-	return true;
+	mStaging.clear();
+	mDirtyRects.clear();
+	mNeedsReadback = false;
+	mDescriptor.width = width;
+	mDescriptor.height = height;
+	mDescriptor.format = format;
+	mDescriptor.levels = 1;
+	mDescriptor.repeated = repeat;
+	mDescriptor.smooth = smooth;
+	mDescriptor.anisotropy = 1.f;
+	mDescriptor.generation++;
 }
 
 void
@@ -82,10 +235,11 @@ Texture::update(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned
 {
 	assert(x + w <= getWidth() && "X target outside the texture");
 	assert(y + h <= getHeight() && "Y target outside the texture");
+	assert(!isCompressed() && "Update of a compressed texture");
 
 	if (mTexture != -1U)
 	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+		GLState::bindTexture(GL_TEXTURE_2D, mTexture);
 		glCheck(glTexSubImage2D(
 			        GL_TEXTURE_2D,
 			        0,
@@ -96,7 +250,25 @@ Texture::update(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned
 			        GL_RGBA,
 			        GL_UNSIGNED_BYTE,
 			        pixels));
-		glCheck(glFlush());
+		invalidateMipmap();
+		mDescriptor.generation++;
+	}
+
+	// NOTE: keep the staging copy in sync, the uploaded texels are
+	// no longer dirty but may be merged with a dirty rectangle
+	if (!mStaging.empty())
+	{
+		const auto *src = static_cast<const std::uint8_t*>(pixels);
+		for (unsigned row = 0; row < h; ++row)
+		{
+			std::copy_n(src + row * w * BYTES_PER_PIXEL,
+			            w * BYTES_PER_PIXEL,
+			            mStaging.data() + ((y + row) * getWidth() + x) * BYTES_PER_PIXEL);
+		}
+	}
+	else if (mTexture != -1U)
+	{
+		mNeedsReadback = true;
 	}
 }
 
@@ -109,12 +281,16 @@ Texture::update(const Texture &other, unsigned x, unsigned y)
 	auto srcHeight = other.getHeight();
 	assert(x + srcWidth <= dstWidth && "X target outside the texture");
 	assert(y + srcHeight <= dstHeight && "Y target outside the texture");
+	assert(!isCompressed() && !other.isCompressed() && "Blit of a compressed texture");
 
 	if (mTexture == -1U || other.mTexture == -1U)
 	{
 		return;
 	}
 
+	// NOTE: the dirty texels would be uploaded over the blit
+	commit();
+
 	GLint oldReadFB, oldDrawFB;
 	glCheck(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &oldReadFB));
 	glCheck(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &oldDrawFB));
@@ -158,6 +334,122 @@ Texture::update(const Texture &other, unsigned x, unsigned y)
 
 	glCheck(glDeleteFramebuffers(1, &readFB));
 	glCheck(glDeleteFramebuffers(1, &drawFB));
+	invalidateMipmap();
+	mDescriptor.generation++;
+
+	// NOTE: the staging copy follows the texels, the dirty ones of
+	// @other must have been committed before the blit; without a
+	// copy of @other it is read back by the next stage(). A texture
+	// created without texels starts its copy from the one of @other.
+	assert(other.mDirtyRects.empty() && "Blit of uncommitted texels");
+	if (!other.mStaging.empty() && (!mStaging.empty() || !mNeedsReadback))
+	{
+		mStaging.resize(dstWidth * dstHeight * BYTES_PER_PIXEL);
+		for (unsigned row = 0; row < srcHeight; ++row)
+		{
+			std::copy_n(other.mStaging.data() + row * srcWidth * BYTES_PER_PIXEL,
+			            srcWidth * BYTES_PER_PIXEL,
+			            mStaging.data() + ((y + row) * dstWidth + x) * BYTES_PER_PIXEL);
+		}
+	}
+	else
+	{
+		mStaging.clear();
+		mNeedsReadback = true;
+	}
+}
+
+void
+Texture::stage(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned h)
+{
+	assert(x + w <= getWidth() && "X target outside the texture");
+	assert(y + h <= getHeight() && "Y target outside the texture");
+	assert(!isCompressed() && "Staging of a compressed texture");
+
+	// NOTE: the copy starts from the texels already on the GPU, the
+	// merged rectangles upload them again unchanged
+	if (mStaging.empty())
+	{
+		mStaging.resize(getWidth() * getHeight() * BYTES_PER_PIXEL);
+		if (mNeedsReadback && mTexture != -1U)
+		{
+			GLState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+			glCheck(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, mStaging.data()));
+		}
+		mNeedsReadback = false;
+	}
+	const auto *src = static_cast<const std::uint8_t*>(pixels);
+	for (unsigned row = 0; row < h; ++row)
+	{
+		std::copy_n(src + row * w * BYTES_PER_PIXEL,
+		            w * BYTES_PER_PIXEL,
+		            mStaging.data() + ((y + row) * getWidth() + x) * BYTES_PER_PIXEL);
+	}
+	addDirtyRect(IntRect(glm::ivec2(x, y), glm::ivec2(w, h)));
+}
+
+void
+Texture::addDirtyRect(IntRect rect)
+{
+	// NOTE: merge while the union does not upload much more than
+	// the rectangles themselves, the staging copy is authoritative
+	bool merged;
+	do
+	{
+		merged = false;
+		for (auto it = mDirtyRects.begin(); it != mDirtyRects.end(); ++it)
+		{
+			const auto united = unite(rect, *it);
+			if (touches(rect, *it) && area(united) <= 2 * (area(rect) + area(*it)))
+			{
+				rect = united;
+				mDirtyRects.erase(it);
+				merged = true;
+				break;
+			}
+		}
+	} while (merged);
+	mDirtyRects.push_back(rect);
+}
+
+void
+Texture::commit()
+{
+	if (mDirtyRects.empty() || mTexture == -1U)
+	{
+		return;
+	}
+
+	// NOTE: the rows of the rectangles are read in place from the
+	// staging copy
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+	glCheck(glPixelStorei(GL_UNPACK_ROW_LENGTH, getWidth()));
+	for (const auto &rect : mDirtyRects)
+	{
+		const auto offset = (rect.pos.y * getWidth() + rect.pos.x) * BYTES_PER_PIXEL;
+		glCheck(glTexSubImage2D(
+			        GL_TEXTURE_2D,
+			        0,
+			        rect.pos.x,
+			        rect.pos.y,
+			        rect.size.x,
+			        rect.size.y,
+			        GL_RGBA,
+			        GL_UNSIGNED_BYTE,
+			        mStaging.data() + offset));
+	}
+	glCheck(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+	mDirtyRects.clear();
+	invalidateMipmap();
+	mDescriptor.generation++;
+}
+
+bool
+Texture::hasStagedTexels() const
+{
+	return !mDirtyRects.empty();
 }
 
 void
@@ -165,116 +457,171 @@ Texture::destroy() noexcept
 {
 	if (mTexture != -1U)
 	{
+		GLState::forgetTexture(mTexture);
 		glCheck(glDeleteTextures(1, &mTexture));
 		mTexture = -1U;
 	}
+
+	mStaging.clear();
+	mDirtyRects.clear();
+	mNeedsReadback = false;
+
+	// NOTE: keep the generation increasing across the recreations
+	mDescriptor = TextureDescriptor{ .generation = mDescriptor.generation + 1 };
 }
 
 void
 Texture::bind() const noexcept
 {
-	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	GLState::bindTexture(GL_TEXTURE_2D, mTexture);
 }
 
 void
 Texture::bind(int textureUnit) const noexcept
 {
-	glCheck(glActiveTexture(GL_TEXTURE0 + textureUnit));
-	glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+	GLState::bindTexture(textureUnit, GL_TEXTURE_2D, mTexture);
 }
 
 glm::vec2
 Texture::getSize() const
 {
-	glm::vec2 size(0.f);
-	if (mTexture != -1U)
-	{
-		GLint width = 0;
-		GLint height = 0;
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-		size.x = static_cast<float>(width);
-		size.y = static_cast<float>(height);
-	}
-	return size;
+	return glm::vec2(mDescriptor.width, mDescriptor.height);
 }
 
 unsigned
 Texture::getWidth() const
 {
-	GLint width = 0;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-	}
-	return width;
+	return mDescriptor.width;
 }
 
 unsigned
 Texture::getHeight() const
 {
-	GLint height = 0;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-	}
-	return height;
+	return mDescriptor.height;
 }
 
 bool
 Texture::isRepeated() const
 {
-	GLint glWrapping = 0;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &glWrapping));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-	}
-	return glWrapping == GL_REPEAT;
+	return mDescriptor.repeated;
 }
 
 void
 Texture::setRepeated(bool repeated)
 {
 	GLint glWrapping = repeated ? GL_REPEAT : GL_CLAMP_TO_EDGE;
-	if (mTexture != -1U)
+	if (mTexture != -1U && repeated != mDescriptor.repeated)
 	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
+		GLState::bindTexture(GL_TEXTURE_2D, mTexture);
 		glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrapping));
 		glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrapping));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+		mDescriptor.repeated = repeated;
 	}
 }
 
 bool
 Texture::isSmooth() const
 {
-	GLint glFiltering = 0;
-	if (mTexture != -1U)
-	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &glFiltering));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
-	}
-	return glFiltering == GL_LINEAR;
+	return mDescriptor.smooth;
 }
 
 void
 Texture::setSmooth(bool smooth)
 {
 	GLint glFiltering = smooth ? GL_LINEAR : GL_NEAREST;
-	if (mTexture != -1U)
+	if (mTexture != -1U && smooth != mDescriptor.smooth)
 	{
-		glCheck(glBindTexture(GL_TEXTURE_2D, mTexture));
-		glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, glFiltering));
+		GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+		glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+		                        getMinFilter(smooth, mDescriptor.levels)));
 		glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, glFiltering));
-		glCheck(glBindTexture(GL_TEXTURE_2D, 0));
+		mDescriptor.smooth = smooth;
+	}
+}
+
+bool
+Texture::generateMipmap()
+{
+	// NOTE: glGenerateMipmap() cannot encode the compressed levels
+	if (mTexture == -1U || isCompressed())
+	{
+		return false;
 	}
+
+	GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+	glCheck(glGenerateMipmap(GL_TEXTURE_2D));
+	glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+	                        getMinFilter(mDescriptor.smooth, 2)));
+	mDescriptor.levels = static_cast<unsigned>(
+		std::bit_width(std::max(getWidth(), getHeight())));
+	return true;
+}
+
+bool
+Texture::hasMipmap() const
+{
+	return mDescriptor.levels > 1;
+}
+
+void
+Texture::invalidateMipmap()
+{
+	// NOTE: the levels below the base are stale, sample only the base
+	// until the chain is generated again
+	if (mDescriptor.levels > 1)
+	{
+		GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+		glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+		                        getMinFilter(mDescriptor.smooth, 1)));
+		mDescriptor.levels = 1;
+	}
+}
+
+void
+Texture::setAnisotropy(float anisotropy)
+{
+	if (!GLEW_EXT_texture_filter_anisotropic)
+	{
+		return;
+	}
+
+	GLfloat maxAnisotropy;
+	glCheck(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy));
+	anisotropy = std::clamp(anisotropy, 1.f, maxAnisotropy);
+	if (mTexture != -1U && anisotropy != mDescriptor.anisotropy)
+	{
+		GLState::bindTexture(GL_TEXTURE_2D, mTexture);
+		glCheck(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy));
+		mDescriptor.anisotropy = anisotropy;
+	}
+}
+
+float
+Texture::getAnisotropy() const
+{
+	return mDescriptor.anisotropy;
+}
+
+bool
+Texture::isReady() const
+{
+	return mDescriptor.ready;
+}
+
+void
+Texture::setReady(bool ready)
+{
+	mDescriptor.ready = ready;
+}
+
+unsigned
+Texture::getNativeHandle() const
+{
+	return mTexture;
+}
+
+const TextureDescriptor &
+Texture::getDescriptor() const
+{
+	return mDescriptor;
 }
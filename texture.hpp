@@ -2,23 +2,87 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <filesystem>
+#include <vector>
+
+#include "rect.hpp"
+#include "s3tc.hpp"
+
+/**
+ * State of a Texture mirrored on the CPU: it is set by create() and
+ * the setters, so reading it never queries GL.
+ */
+struct TextureDescriptor
+{
+	unsigned width = 0;
+	unsigned height = 0;
+	unsigned format = 0;
+	unsigned levels = 0;
+	bool     repeated = false;
+	bool     smooth = false;
+	float    anisotropy = 1.f;
+
+	/** Cleared while the texels are still being loaded. */
+	bool     ready = true;
+
+	/** Changed by every create() and update() of the texels. */
+	unsigned generation = 0;
+};
 
 class Texture
 {
 public:
 	Texture();
 
-	bool loadFromFile(const std::filesystem::path &path);
+	/**
+	 * Load the image at @path, compressed with the @compression when
+	 * the GPU supports S3TC; the compressed blocks are cached next to
+	 * the image. An image which cannot be compressed is loaded as RGBA.
+	 */
+	bool loadFromFile(const std::filesystem::path &path,
+	                  TextureCompression compression = TextureCompression::None);
 
 	bool create(unsigned width, unsigned height,
 	            const void *pixels=nullptr,
 	            bool repeat=false, bool smooth=false);
 
+	/**
+	 * Create a texture compressed in the S3TC @format from the rows
+	 * of @blocks, nullptr leaves the texels undefined. The texels of
+	 * a compressed texture cannot be updated, staged or blitted and
+	 * it has no mip chain.
+	 */
+	bool create(unsigned width, unsigned height,
+	            TextureCompression format,
+	            const void *blocks=nullptr,
+	            bool repeat=false, bool smooth=false);
+	bool isCompressed() const;
+
+	/**
+	 * Check if the GPU supports the S3TC formats, the callers fall
+	 * back to uncompressed textures otherwise.
+	 */
+	static bool isCompressionAvailable();
+
 	void update(const void *pixels);
 	void update(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned h);
 	void update(const Texture &other, unsigned x = 0, unsigned y = 0);
 
+	/**
+	 * Copy the texels in a CPU staging copy of the texture and mark
+	 * the rectangle dirty, the touching rectangles are merged. The
+	 * copy mirrors the whole texture, it is read back from the GPU
+	 * when created over texels set by create() or update().
+	 */
+	void stage(const void *pixels, unsigned x, unsigned y, unsigned w, unsigned h);
+
+	/**
+	 * Upload the dirty rectangles of the staging copy.
+	 */
+	void commit();
+	bool hasStagedTexels() const;
+
 	void destroy() noexcept;
 	void bind() const noexcept;
 	void bind(int textureUnit) const noexcept;
@@ -34,6 +98,44 @@ public:
 	bool isSmooth() const;
 	void setSmooth(bool smooth);
 
+	/**
+	 * Generate the mip chain on the GPU: the minification then reads
+	 * the closest levels, linearly blended between them (trilinear)
+	 * when the texture is smooth. The chain is dropped by the next
+	 * update of the texels.
+	 * @return false if the texture was not created
+	 */
+	bool generateMipmap();
+	bool hasMipmap() const;
+
+	/**
+	 * Set the number of samples taken along the axis of anisotropy,
+	 * clamped to the limit of the driver; 1 disables the anisotropic
+	 * filtering, which is ignored without the extension.
+	 */
+	void setAnisotropy(float anisotropy);
+	float getAnisotropy() const;
+
+	/**
+	 * A texture is not ready while TextureLoader is uploading its
+	 * texels, RenderTarget draws a placeholder instead.
+	 */
+	bool isReady() const;
+	void setReady(bool ready);
+
+	unsigned getNativeHandle() const;
+	const TextureDescriptor &getDescriptor() const;
+
+private:
+	void setParameters(unsigned width, unsigned height, unsigned format,
+	                   bool repeat, bool smooth);
+	void addDirtyRect(IntRect rect);
+	void invalidateMipmap();
+
 private:
+	TextureDescriptor mDescriptor;
+	std::vector<std::uint8_t> mStaging;
+	std::vector<IntRect> mDirtyRects;
+	bool mNeedsReadback;
 	unsigned mTexture;
 };
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <memory>
+
+#include <GL/glew.h>
+
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "texturearray.hpp"
+#include "stb_image.h"
+
+namespace
+{
+struct ImageDeleter
+{
+	void operator()(unsigned char *pixels) const
+	{
+		stbi_image_free(pixels);
+	}
+};
+
+struct Image
+{
+	std::unique_ptr<unsigned char, ImageDeleter> pixels;
+	unsigned width;
+	unsigned height;
+};
+}
+
+TextureArray::TextureArray()
+	: mLayerScales()
+	, mSize(0.f)
+	, mTexture(-1U)
+{
+}
+
+bool
+TextureArray::loadFromFiles(std::span<const std::filesystem::path> paths)
+{
+	// decode all the images to find the size of the layers
+	std::vector<Image> images;
+	unsigned width = 0;
+	unsigned height = 0;
+	for (const auto &path : paths)
+	{
+		int w, h, channels;
+		auto *pixels = stbi_load(path.c_str(), &w, &h, &channels, 4);
+		if (pixels == nullptr)
+		{
+			std::cerr << "TextureArray::loadFromFiles() - Unable to load "
+			          << path.string() << std::endl;
+			return false;
+		}
+		images.emplace_back(
+			std::unique_ptr<unsigned char, ImageDeleter>(pixels),
+			static_cast<unsigned>(w),
+			static_cast<unsigned>(h));
+		width = std::max(width, images.back().width);
+		height = std::max(height, images.back().height);
+	}
+
+	if (!create(width, height, images.size()))
+	{
+		return false;
+	}
+	for (unsigned layer = 0; layer < images.size(); ++layer)
+	{
+		const auto &image = images[layer];
+		setImage(layer, image.pixels.get(), image.width, image.height);
+	}
+	return true;
+}
+
+bool
+TextureArray::create(unsigned width, unsigned height, unsigned layers)
+{
+	if (width == 0 || height == 0 || layers == 0)
+	{
+		std::cerr << "TextureArray::create() - Invalid texture size ("
+		          << width << ", " << height << ", " << layers << ")"
+		          << std::endl;
+		return false;
+	}
+
+	if (mTexture == -1U)
+	{
+		glCheck(glGenTextures(1, &mTexture));
+	}
+
+	// NOTE: clear the layers, images may not cover them entirely
+	std::vector<std::uint8_t> zero(width * height * layers * 4, 0);
+	GLState::bindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+	glCheck(glTexImage3D(
+		        GL_TEXTURE_2D_ARRAY,
+		        0,
+		        GL_RGBA,
+		        static_cast<GLsizei>(width),
+		        static_cast<GLsizei>(height),
+		        static_cast<GLsizei>(layers),
+		        0,
+		        GL_RGBA,
+		        GL_UNSIGNED_BYTE,
+		        zero.data()));
+	glCheck(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	glCheck(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	glCheck(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	glCheck(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+
+	mSize = glm::vec2(width, height);
+	mLayerScales.assign(layers, glm::vec2(1.f));
+	return true;
+}
+
+void
+TextureArray::update(unsigned layer, const void *pixels,
+                     unsigned x, unsigned y, unsigned w, unsigned h)
+{
+	assert(layer < mLayerScales.size() && "Layer outside the texture");
+	assert(x + w <= mSize.x && "X target outside the texture");
+	assert(y + h <= mSize.y && "Y target outside the texture");
+
+	if (mTexture != -1U)
+	{
+		GLState::bindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+		glCheck(glTexSubImage3D(
+			        GL_TEXTURE_2D_ARRAY,
+			        0,
+			        static_cast<GLint>(x),
+			        static_cast<GLint>(y),
+			        static_cast<GLint>(layer),
+			        static_cast<GLsizei>(w),
+			        static_cast<GLsizei>(h),
+			        1,
+			        GL_RGBA,
+			        GL_UNSIGNED_BYTE,
+			        pixels));
+	}
+}
+
+void
+TextureArray::setImage(unsigned layer, const void *pixels,
+                       unsigned width, unsigned height)
+{
+	update(layer, pixels, 0, 0, width, height);
+	mLayerScales[layer] = glm::vec2(width, height) / mSize;
+}
+
+void
+TextureArray::destroy() noexcept
+{
+	if (mTexture != -1U)
+	{
+		GLState::forgetTexture(mTexture);
+		glCheck(glDeleteTextures(1, &mTexture));
+		mTexture = -1U;
+	}
+}
+
+void
+TextureArray::bind(int textureUnit) const noexcept
+{
+	GLState::bindTexture(textureUnit, GL_TEXTURE_2D_ARRAY, mTexture);
+}
+
+glm::vec2
+TextureArray::getSize() const
+{
+	return mSize;
+}
+
+unsigned
+TextureArray::getLayerCount() const
+{
+	return mLayerScales.size();
+}
+
+glm::vec2
+TextureArray::getLayerScale(unsigned layer) const
+{
+	assert(layer < mLayerScales.size() && "Layer outside the texture");
+	return mLayerScales[layer];
+}
+
+unsigned
+TextureArray::getNativeHandle() const
+{
+	return mTexture;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/**
+ * GL_TEXTURE_2D_ARRAY made of images of different sizes.
+ *
+ * Every layer has the size of the biggest image and each image is
+ * stored in the top left corner of its layer, the UV coordinates
+ * relative to the image must be multiplied by getLayerScale().
+ */
+class TextureArray
+{
+public:
+	TextureArray();
+
+	bool loadFromFiles(std::span<const std::filesystem::path> paths);
+
+	bool create(unsigned width, unsigned height, unsigned layers);
+	void update(unsigned layer, const void *pixels,
+	            unsigned x, unsigned y, unsigned w, unsigned h);
+
+	/**
+	 * Store the image in the top left corner of the @layer and
+	 * update its scale.
+	 */
+	void setImage(unsigned layer, const void *pixels,
+	              unsigned width, unsigned height);
+
+	void destroy() noexcept;
+	void bind(int textureUnit) const noexcept;
+
+	glm::vec2 getSize() const;
+	unsigned getLayerCount() const;
+	glm::vec2 getLayerScale(unsigned layer) const;
+
+	unsigned getNativeHandle() const;
+
+private:
+	std::vector<glm::vec2> mLayerScales;
+	glm::vec2 mSize;
+	unsigned  mTexture;
+};
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <GL/glew.h>
+
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "stb_image.h"
+#include "texture.hpp"
+#include "textureloader.hpp"
+
+namespace
+{
+const std::size_t BYTES_PER_PIXEL = 4;
+const unsigned BLOCK_SIZE = 4;
+}
+
+TextureLoader::TextureLoader()
+	: mRequests()
+	, mThreadPool()
+	, mUploadBuffer()
+	, mBytesPerFrame(0)
+{
+}
+
+bool
+TextureLoader::create(unsigned workers, std::size_t bytesPerFrame)
+{
+	mBytesPerFrame = bytesPerFrame;
+	mThreadPool.create(workers);
+	if (!mUploadBuffer.create(GL_PIXEL_UNPACK_BUFFER, bytesPerFrame))
+	{
+		return false;
+	}
+
+	// NOTE: a bound unpack buffer would turn the pixel pointers of
+	// the other uploads into offsets
+	GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return true;
+}
+
+void
+TextureLoader::destroy()
+{
+	// NOTE: wait for the decodes in flight before freeing them
+	mThreadPool.destroy();
+	for (auto &request : mRequests)
+	{
+		stbi_image_free(request->pixels);
+	}
+	mRequests.clear();
+	mUploadBuffer.destroy();
+}
+
+bool
+TextureLoader::load(Texture &texture, const std::filesystem::path &path, bool mipmap,
+                    TextureCompression compression)
+{
+	int width, height, channels;
+	if (!stbi_info(path.c_str(), &width, &height, &channels))
+	{
+		std::cerr << "TextureLoader::load() - Unable to load "
+		          << path.string() << std::endl;
+		return false;
+	}
+	if (static_cast<std::size_t>(width) * BYTES_PER_PIXEL > mBytesPerFrame)
+	{
+		std::cerr << "TextureLoader::load() - The rows of "
+		          << path.string() << " exceed the upload budget" << std::endl;
+		return false;
+	}
+
+	// NOTE: the storage is allocated now so that the size of the
+	// texture is known while it is loading
+	if (!texture.create(width, height))
+	{
+		return false;
+	}
+	texture.setReady(false);
+
+	auto request = std::make_shared<Request>();
+	request->texture = &texture;
+	request->path = path;
+	request->mipmap = mipmap;
+	request->compression = Texture::isCompressionAvailable()
+		? compression
+		: TextureCompression::None;
+	request->width = width;
+	request->height = height;
+	mRequests.push_back(request);
+
+	mThreadPool.submit([request] {
+		if (request->compression != TextureCompression::None
+		    && S3TC::load(request->path, request->compression, request->image))
+		{
+			request->decoded.store(true, std::memory_order_release);
+			return;
+		}
+
+		// NOTE: a source which cannot be compressed is still loaded
+		request->image.format = TextureCompression::None;
+		int width, height, channels;
+		request->pixels = stbi_load(request->path.c_str(),
+		                            &width, &height, &channels,
+		                            BYTES_PER_PIXEL);
+		if (request->pixels == nullptr)
+		{
+			std::cerr << "TextureLoader::load() - Unable to decode "
+			          << request->path.string() << std::endl;
+		}
+		request->decoded.store(true, std::memory_order_release);
+	});
+	return true;
+}
+
+void
+TextureLoader::update()
+{
+	std::size_t budget = mBytesPerFrame;
+	while (!mRequests.empty())
+	{
+		// NOTE: the textures are uploaded in the order of the requests
+		auto &request = *mRequests.front();
+		if (!request.decoded.load(std::memory_order_acquire))
+		{
+			break;
+		}
+
+		// NOTE: the rows of a compressed image are rows of blocks
+		const auto format = request.image.format;
+		const bool compressed = format != TextureCompression::None;
+		const bool loaded = compressed || request.pixels;
+		const std::size_t pitch = compressed
+			? S3TC::getRowPitch(format, request.width)
+			: request.width * BYTES_PER_PIXEL;
+		const unsigned height = compressed
+			? S3TC::getBlockRows(request.height)
+			: request.height;
+		const unsigned rows = std::min<std::size_t>(
+			height - request.row,
+			budget / pitch);
+		if (loaded && rows == 0)
+		{
+			break;
+		}
+
+		if (compressed && !request.texture->isCompressed())
+		{
+			request.texture->create(request.width, request.height, format);
+		}
+
+		if (loaded)
+		{
+			const std::uint8_t *source = compressed
+				? request.image.blocks.data()
+				: request.pixels;
+			const std::size_t size = rows * pitch;
+			void *ptr = mUploadBuffer.map(size, BYTES_PER_PIXEL);
+			std::memcpy(ptr, source + request.row * pitch, size);
+			mUploadBuffer.unmap(size);
+
+			// the source of the upload is the offset in the bound PBO
+			const auto offset = reinterpret_cast<GLvoid*>(mUploadBuffer.getOffset());
+			GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, mUploadBuffer.getNativeHandle());
+			request.texture->bind();
+			if (compressed)
+			{
+				const unsigned y = request.row * BLOCK_SIZE;
+				glCheck(glCompressedTexSubImage2D(
+					        GL_TEXTURE_2D,
+					        0,
+					        0,
+					        y,
+					        request.width,
+					        std::min(rows * BLOCK_SIZE, request.height - y),
+					        request.texture->getDescriptor().format,
+					        size,
+					        offset));
+			}
+			else
+			{
+				glCheck(glTexSubImage2D(
+					        GL_TEXTURE_2D,
+					        0,
+					        0,
+					        request.row,
+					        request.width,
+					        rows,
+					        GL_RGBA,
+					        GL_UNSIGNED_BYTE,
+					        offset));
+			}
+			GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			mUploadBuffer.fence();
+			request.row += rows;
+			budget -= size;
+			if (request.row < height)
+			{
+				break;
+			}
+		}
+
+		if (request.pixels && request.mipmap)
+		{
+			request.texture->generateMipmap();
+		}
+
+		// NOTE: an image which failed to decode keeps the placeholder
+		request.texture->setReady(loaded);
+		stbi_image_free(request.pixels);
+		mRequests.pop_front();
+	}
+}
+
+bool
+TextureLoader::isIdle() const
+{
+	return mRequests.empty();
+}
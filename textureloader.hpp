@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <memory>
+
+#include "s3tc.hpp"
+#include "streambuffer.hpp"
+#include "threadpool.hpp"
+
+class Texture;
+
+/**
+ * Loads the textures in the background.
+ *
+ * The images are decoded by worker threads and update() streams the
+ * decoded rows to the GPU through a pixel unpack buffer, within a
+ * budget of bytes for each frame. The textures get their final size
+ * right away and are marked ready once all their rows have been
+ * uploaded, in the meantime RenderTarget draws a placeholder. The
+ * compressed textures are streamed by rows of blocks.
+ */
+class TextureLoader
+{
+public:
+	TextureLoader();
+
+	TextureLoader(const TextureLoader &) = delete;
+	TextureLoader& operator=(const TextureLoader &) = delete;
+	TextureLoader(TextureLoader &&) noexcept = delete;
+	TextureLoader& operator=(TextureLoader &&) noexcept = delete;
+
+	/**
+	 * Start @workers decoding threads and upload at most
+	 * @bytesPerFrame bytes in each update().
+	 */
+	bool create(unsigned workers, std::size_t bytesPerFrame);
+	void destroy();
+
+	/**
+	 * Load the image at @path into @texture, which must outlive the
+	 * request. Only the header is read by the caller.
+	 * @param[in] mipmap generate the mip chain once it is uploaded
+	 * @param[in] compression compress the texture when the GPU
+	 *            supports S3TC, the blocks are cached by the workers
+	 */
+	bool load(Texture &texture, const std::filesystem::path &path, bool mipmap = false,
+	          TextureCompression compression = TextureCompression::None);
+
+	/**
+	 * Upload the decoded rows within the budget, to be called once
+	 * per frame.
+	 */
+	void update();
+
+	/**
+	 * Check if all the requested textures are ready.
+	 */
+	bool isIdle() const;
+
+private:
+	struct Request
+	{
+		Texture *texture;
+		std::filesystem::path path;
+		unsigned char *pixels = nullptr;
+		unsigned width = 0;
+		unsigned height = 0;
+		unsigned row = 0;
+		bool mipmap = false;
+		TextureCompression compression = TextureCompression::None;
+		CompressedImage image;
+		std::atomic<bool> decoded{ false };
+	};
+
+private:
+	std::deque<std::shared_ptr<Request>> mRequests;
+	ThreadPool   mThreadPool;
+	StreamBuffer mUploadBuffer;
+	std::size_t  mBytesPerFrame;
+};
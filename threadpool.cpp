@@ -0,0 +1,166 @@
+#include <algorithm>
+
+#include "threadpool.hpp"
+
+ThreadPool::ThreadPool()
+	: mThreads()
+	, mMutex()
+	, mWake()
+	, mDone()
+	, mJobs()
+	, mTask(nullptr)
+	, mCount(0)
+	, mGrain(1)
+	, mNext(0)
+	, mActive(0)
+	, mGeneration(0)
+	, mQuit(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+	destroy();
+}
+
+void
+ThreadPool::create(unsigned workers)
+{
+	destroy();
+	mQuit = false;
+	for (unsigned i = 0; i < workers; ++i)
+	{
+		mThreads.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+void
+ThreadPool::destroy()
+{
+	{
+		std::lock_guard lock(mMutex);
+		mQuit = true;
+	}
+	mWake.notify_all();
+	for (auto &thread : mThreads)
+	{
+		thread.join();
+	}
+	mThreads.clear();
+	mJobs.clear();
+}
+
+unsigned
+ThreadPool::getWorkerCount() const
+{
+	return mThreads.size();
+}
+
+void
+ThreadPool::parallelFor(std::size_t count, std::size_t grain, const Task &task)
+{
+	grain = std::max<std::size_t>(grain, 1);
+	if (mThreads.empty() || count <= grain)
+	{
+		task(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard lock(mMutex);
+		mTask = &task;
+		mCount = count;
+		mGrain = grain;
+		mNext = 0;
+		++mGeneration;
+	}
+	mWake.notify_all();
+
+	// NOTE: the caller works too instead of just waiting, once it
+	// runs out of chunks only the workers still busy are waited for
+	runChunks();
+
+	std::unique_lock lock(mMutex);
+	mDone.wait(lock, [this] { return mActive == 0; });
+	mTask = nullptr;
+}
+
+void
+ThreadPool::submit(Job job)
+{
+	if (mThreads.empty())
+	{
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard lock(mMutex);
+		mJobs.push_back(std::move(job));
+	}
+	mWake.notify_one();
+}
+
+void
+ThreadPool::work()
+{
+	unsigned generation;
+	{
+		std::lock_guard lock(mMutex);
+		generation = mGeneration;
+	}
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock lock(mMutex);
+			mWake.wait(lock, [&] {
+				return mQuit
+					|| (mTask && mGeneration != generation)
+					|| !mJobs.empty();
+			});
+			if (mQuit)
+			{
+				return;
+			}
+			if (mTask && mGeneration != generation)
+			{
+				generation = mGeneration;
+				mActive++;
+			}
+			else
+			{
+				job = std::move(mJobs.front());
+				mJobs.pop_front();
+			}
+		}
+
+		if (job)
+		{
+			job();
+			continue;
+		}
+
+		runChunks();
+
+		std::lock_guard lock(mMutex);
+		if (--mActive == 0)
+		{
+			mDone.notify_one();
+		}
+	}
+}
+
+void
+ThreadPool::runChunks()
+{
+	for (;;)
+	{
+		const auto begin = mNext.fetch_add(mGrain);
+		if (begin >= mCount)
+		{
+			break;
+		}
+		(*mTask)(begin, std::min(begin + mGrain, mCount));
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads for data parallel loops and background
+ * jobs.
+ *
+ * parallelFor() splits a range in chunks which are consumed by the
+ * workers and by the calling thread, and returns when all the chunks
+ * have been processed. submit() queues a job which runs on the first
+ * free worker; the loops take precedence over the queued jobs and
+ * never wait for a worker busy with one.
+ */
+class ThreadPool
+{
+public:
+	typedef std::function<void(std::size_t begin, std::size_t end)> Task;
+	typedef std::function<void()> Job;
+
+public:
+	ThreadPool();
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool& operator=(const ThreadPool &) = delete;
+	ThreadPool(ThreadPool &&) noexcept = delete;
+	ThreadPool& operator=(ThreadPool &&) noexcept = delete;
+
+	/**
+	 * Start @workers threads, zero runs everything on the caller.
+	 */
+	void create(unsigned workers);
+	void destroy();
+
+	unsigned getWorkerCount() const;
+
+	/**
+	 * Call @task on the chunks of [0, @count) of at most @grain
+	 * elements, the chunks do not overlap.
+	 */
+	void parallelFor(std::size_t count, std::size_t grain, const Task &task);
+
+	/**
+	 * Run @job on a worker thread, or right away on the caller when
+	 * there are no workers. The jobs still queued are dropped by
+	 * destroy().
+	 */
+	void submit(Job job);
+
+private:
+	void work();
+	void runChunks();
+
+private:
+	std::vector<std::thread> mThreads;
+	std::mutex               mMutex;
+	std::condition_variable  mWake;
+	std::condition_variable  mDone;
+
+	std::deque<Job>          mJobs;
+	const Task              *mTask;
+	std::size_t              mCount;
+	std::size_t              mGrain;
+	std::atomic<std::size_t> mNext;
+	unsigned                 mActive;
+	unsigned                 mGeneration;
+	bool                     mQuit;
+};
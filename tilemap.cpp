@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "atlas.hpp"
+#include "glcheck.hpp"
+#include "glstate.hpp"
+#include "quad.hpp"
+#include "texturearray.hpp"
+#include "tilemap.hpp"
+
+namespace
+{
+// NOTE: one chunk covers the height of the screen
+const float CHUNK_HEIGHT = 480.f;
+}
+
+TileMap::TileMap()
+	: mSize(0.f)
+	, mChunkHeight(0.f)
+	, mChunkQuads(0)
+	, mQuadCount(0)
+	, mTexture(0)
+	, mVAO(0)
+	, mVBO(0)
+	, mEBO(0)
+{
+}
+
+bool
+TileMap::loadFromFile(const std::filesystem::path &path,
+                      const Atlas &atlas,
+                      const TextureArray &texture)
+{
+	std::ifstream in(path);
+	if (!in)
+	{
+		std::cerr << "TileMap::loadFromFile() - Unable to open "
+		          << path.string() << std::endl;
+		return false;
+	}
+
+	// skip the comments and read the header
+	std::stringstream level;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line[0] != '#')
+		{
+			level << line << "\n";
+		}
+	}
+	std::string tilesetKey, frameName, mapKey;
+	glm::ivec2 tileSize, mapSize;
+	level >> tilesetKey >> frameName >> tileSize.x >> tileSize.y
+	      >> mapKey >> mapSize.x >> mapSize.y;
+	if (!level || tilesetKey != "tileset" || mapKey != "map"
+	    || tileSize.x <= 0 || tileSize.y <= 0
+	    || mapSize.x <= 0 || mapSize.y <= 0)
+	{
+		std::cerr << "TileMap::loadFromFile() - Invalid header in "
+		          << path.string() << std::endl;
+		return false;
+	}
+
+	// NOTE: the tiles are cut from the frame in row major order
+	const auto &frame = atlas.getFrame(frameName);
+	const auto scale = texture.getLayerScale(frame.layer);
+	const glm::ivec2 tilesetSize = glm::ivec2(frame.size) / tileSize;
+	const glm::vec2 uvTile = frame.uvSize * glm::vec2(tileSize) / frame.size * scale;
+	const unsigned tileCount = tilesetSize.x * tilesetSize.y;
+
+	std::vector<Vertex> vertices;
+	std::vector<unsigned> quadIndices;
+	vertices.reserve(mapSize.x * mapSize.y * 4);
+	quadIndices.reserve(mapSize.x * mapSize.y * 6);
+	for (int row = 0; row < mapSize.y; ++row)
+	{
+		for (int col = 0; col < mapSize.x; ++col)
+		{
+			unsigned tile;
+			if (!(level >> tile) || tile >= tileCount)
+			{
+				std::cerr << "TileMap::loadFromFile() - Invalid tile at ("
+				          << col << ", " << row << ") in "
+				          << path.string() << std::endl;
+				return false;
+			}
+
+			const glm::vec2 pos = glm::vec2(col, row) * glm::vec2(tileSize);
+			const glm::vec2 uvPos = frame.uvPos * scale + uvTile * glm::vec2(
+				tile % tilesetSize.x, tile / tilesetSize.x);
+			const unsigned base = vertices.size();
+			for (auto unit : Quad::units)
+			{
+				vertices.push_back(Vertex{
+						unit * glm::vec2(tileSize) + pos,
+						unit * uvTile + uvPos,
+						static_cast<float>(frame.layer),
+					});
+			}
+			for (auto i : Quad::indices)
+			{
+				quadIndices.push_back(base + i);
+			}
+		}
+	}
+
+	mSize = glm::vec2(mapSize * tileSize);
+	mChunkHeight = std::max(1.f, std::floor(CHUNK_HEIGHT / tileSize.y)) * tileSize.y;
+	mChunkQuads = mChunkHeight / tileSize.y * mapSize.x;
+	mQuadCount = mapSize.x * mapSize.y;
+	mTexture = texture.getNativeHandle();
+
+	// NOTE: upload the indices through GL_ARRAY_BUFFER before the
+	// VAO is bound, the element buffer binding belongs to the VAO
+	if (mVAO == 0)
+	{
+		glCheck(glGenVertexArrays(1, &mVAO));
+		glCheck(glGenBuffers(1, &mVBO));
+		glCheck(glGenBuffers(1, &mEBO));
+	}
+	GLState::bindBuffer(GL_ARRAY_BUFFER, mEBO);
+	glCheck(glBufferData(GL_ARRAY_BUFFER,
+	                     quadIndices.size() * sizeof(quadIndices[0]),
+	                     quadIndices.data(),
+	                     GL_STATIC_DRAW));
+	GLState::bindBuffer(GL_ARRAY_BUFFER, mVBO);
+	glCheck(glBufferData(GL_ARRAY_BUFFER,
+	                     vertices.size() * sizeof(vertices[0]),
+	                     vertices.data(),
+	                     GL_STATIC_DRAW));
+
+	GLState::bindVertexArray(mVAO);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+	glCheck(glEnableVertexAttribArray(0));
+	glCheck(glVertexAttribPointer(
+		        0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		        reinterpret_cast<GLvoid*>(offsetof(Vertex, pos))));
+	glCheck(glEnableVertexAttribArray(1));
+	glCheck(glVertexAttribPointer(
+		        1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		        reinterpret_cast<GLvoid*>(offsetof(Vertex, uv))));
+	glCheck(glEnableVertexAttribArray(3));
+	glCheck(glVertexAttribPointer(
+		        3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+		        reinterpret_cast<GLvoid*>(offsetof(Vertex, layer))));
+	return true;
+}
+
+void
+TileMap::destroy()
+{
+	if (mVAO)
+	{
+		GLState::forgetVertexArray(mVAO);
+		glCheck(glDeleteVertexArrays(1, &mVAO));
+		GLState::forgetBuffer(mVBO);
+		GLState::forgetBuffer(mEBO);
+		glCheck(glDeleteBuffers(1, &mVBO));
+		glCheck(glDeleteBuffers(1, &mEBO));
+		mVAO = mVBO = mEBO = 0;
+	}
+}
+
+glm::vec2
+TileMap::getSize() const
+{
+	return mSize;
+}
+
+std::pair<unsigned, unsigned>
+TileMap::getVisibleQuads(float top, float height) const
+{
+	if (mQuadCount == 0 || top >= mSize.y || top + height <= 0.f)
+	{
+		return { 0, 0 };
+	}
+	const auto first = static_cast<unsigned>(std::max(top, 0.f) / mChunkHeight);
+	const auto last = static_cast<unsigned>(
+		std::ceil(std::min(top + height, mSize.y) / mChunkHeight));
+	const unsigned begin = first * mChunkQuads;
+	const unsigned end = std::min(last * mChunkQuads, mQuadCount);
+	return { begin, end - begin };
+}
+
+unsigned
+TileMap::getTexture() const
+{
+	return mTexture;
+}
+
+unsigned
+TileMap::getVertexArray() const
+{
+	return mVAO;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <filesystem>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+class Atlas;
+class TextureArray;
+
+/**
+ * Static background made of tiles cut from an atlas frame.
+ *
+ * The level file has the form:
+ *
+ *   tileset <atlas frame> <tile width> <tile height>
+ *   map <columns> <rows>
+ *   <rows> lines of <columns> tile indices, from the top
+ *
+ * The tiles are uploaded once in a static buffer, in chunks one
+ * screen tall laid out from the top of the map; the visible chunks
+ * are contiguous and drawn with a single call.
+ */
+class TileMap
+{
+public:
+	struct Vertex
+	{
+		glm::vec2 pos;
+		glm::vec2 uv;
+		float layer;
+	};
+
+public:
+	TileMap();
+
+	TileMap(const TileMap &) = delete;
+	TileMap& operator=(const TileMap &) = delete;
+	TileMap(TileMap &&) noexcept = delete;
+	TileMap& operator=(TileMap &&) noexcept = delete;
+
+	bool loadFromFile(const std::filesystem::path &path,
+	                  const Atlas &atlas,
+	                  const TextureArray &texture);
+	void destroy();
+
+	glm::vec2 getSize() const;
+
+	/**
+	 * Get the range of quads of the chunks which intersect the
+	 * rows [@top, @top + @height) of the map.
+	 * @return the first quad and the number of quads
+	 */
+	std::pair<unsigned, unsigned> getVisibleQuads(float top, float height) const;
+
+	unsigned getTexture() const;
+	unsigned getVertexArray() const;
+
+private:
+	glm::vec2 mSize;
+	float     mChunkHeight;
+	unsigned  mChunkQuads;
+	unsigned  mQuadCount;
+	unsigned  mTexture;
+	unsigned  mVAO;
+	unsigned  mVBO;
+	unsigned  mEBO;
+};
@@ -18,19 +18,34 @@ const std::string PressKey = "Press a key to start!";
 
 TitleState::TitleState()
 	: mRectangle()
+	, mBackground()
+	, mBackgroundReady(false)
+	, mText()
 	, mShowText(true)
 	, mElapsedTime(0.f)
 {
 	auto &font = world.fonts.get(FontID::Title);
 	glm::vec2 windowSize = glm::vec2(640.f, 480.f);
-	glm::vec2 textSize = font.getSize(PressKey);
-
-	mTextPos = windowSize * glm::vec2(.5f, .8f) - textSize * 0.5f;
+	mText.setFont(font);
+	mText.setString(PressKey);
+	glm::vec2 textSize = mText.getSize();
+	mText.setPosition(windowSize * glm::vec2(.5f, .8f) - textSize * 0.5f);
 
 	mRectangle.setColor(Color::fromRGBA(50, 50, 50, 150));
 	mRectangle.setSize(textSize * 1.2f);
 	mRectangle.centerOrigin();
 	mRectangle.move(windowSize * glm::vec2(0.5f, 0.8f));
+
+	if (!mBackground.create(windowSize.x, windowSize.y))
+	{
+		throw std::runtime_error("TitleState - Unable to create the background");
+	}
+}
+
+TitleState::~TitleState()
+{
+	mText.destroy();
+	mBackground.destroy();
 }
 
 bool
@@ -61,13 +76,34 @@ TitleState::handleEvent(const Event &event)
 void
 TitleState::draw(RenderTarget &target)
 {
-	auto &font = world.fonts.get(FontID::Title);
+	// NOTE: the background and its overlay never change
+	if (!mBackgroundReady)
+	{
+		target.setRenderTexture(&mBackground);
+		target.clear();
+		target.setLayer(LAYER_BACKGROUND);
+		target.draw(world.textures.get(TextureID::TitleScreen), glm::vec2(0.f));
+		target.setLayer(LAYER_OVERLAY);
+		target.draw(mRectangle);
+		target.setRenderTexture(nullptr);
+
+		// NOTE: draw it again once the image has been loaded
+		mBackgroundReady = world.textures.get(TextureID::TitleScreen).isReady();
+	}
 
-	target.clear();
-	target.draw(world.textures.get(TextureID::TitleScreen), glm::vec2(0.f));
-	target.draw(mRectangle);
+	target.setLayer(LAYER_BACKGROUND);
+	target.setBlendMode(BlendMode::None);
+	target.draw(mBackground.getTexture(), glm::vec2(0.f));
+	target.setBlendMode(BlendMode::Alpha);
 	if (mShowText)
 	{
-		target.draw(PressKey, mTextPos, font, Color::White);
+		target.setLayer(LAYER_TEXT);
+		target.draw(mText);
 	}
 }
+
+bool
+TitleState::isOpaque() const
+{
+	return true;
+}
@@ -2,20 +2,26 @@
 
 #include "resources.hpp"
 #include "rectangleshape.hpp"
+#include "rendertexture.hpp"
 #include "state.hpp"
+#include "text.hpp"
 
 class TitleState: public State
 {
 public:
 	TitleState();
+	~TitleState() override;
 
 	bool update(float dt) override;
 	bool handleEvent(const Event &event) override;
 	void draw(RenderTarget &target) override;
+	bool isOpaque() const override;
 
 private:
 	RectangleShape mRectangle;
-	glm::vec2      mTextPos;
+	RenderTexture  mBackground;
+	bool           mBackgroundReady;
+	Text           mText;
 	bool           mShowText;
 	float          mElapsedTime;
 };
@@ -0,0 +1,116 @@
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "view.hpp"
+
+View::View()
+	: View(FloatRect(glm::vec2(0.f), glm::vec2(1.f)))
+{
+}
+
+View::View(glm::vec2 center, glm::vec2 size)
+	: mCenter(center)
+	, mSize(size)
+	, mZoom(1.f)
+	, mRotation(0.f)
+{
+}
+
+View::View(const FloatRect &rect)
+	: View(rect.pos + rect.size * 0.5f, rect.size)
+{
+}
+
+glm::vec2
+View::getCenter() const
+{
+	return mCenter;
+}
+
+void
+View::setCenter(glm::vec2 center)
+{
+	mCenter = center;
+}
+
+glm::vec2
+View::getSize() const
+{
+	return mSize;
+}
+
+void
+View::setSize(glm::vec2 size)
+{
+	mSize = size;
+}
+
+float
+View::getZoom() const
+{
+	return mZoom;
+}
+
+void
+View::setZoom(float zoom)
+{
+	mZoom = zoom;
+}
+
+float
+View::getRotation() const
+{
+	return mRotation;
+}
+
+void
+View::setRotation(float rotation)
+{
+	mRotation = rotation;
+}
+
+void
+View::move(glm::vec2 offset)
+{
+	setCenter(mCenter + offset);
+}
+
+void
+View::reset(const FloatRect &rect)
+{
+	mCenter = rect.pos + rect.size * 0.5f;
+	mSize = rect.size;
+	mZoom = 1.f;
+	mRotation = 0.f;
+}
+
+glm::mat4
+View::getProjection() const
+{
+	// NOTE: y grows downwards like in the window coordinates
+	const glm::vec2 half = mSize * 0.5f / mZoom;
+	return glm::ortho(-half.x, half.x, half.y, -half.y, -1.f, 1.f);
+}
+
+glm::mat4
+View::getViewMatrix() const
+{
+	return glm::translate(
+		glm::rotate(
+			glm::mat4(1.f),
+			glm::radians(-mRotation),
+			glm::vec3(0.f, 0.f, 1.f)),
+		glm::vec3(-mCenter, 0.f));
+}
+
+FloatRect
+View::getBounds() const
+{
+	const glm::vec2 half = mSize * 0.5f / mZoom;
+	const float angle = glm::radians(mRotation);
+	const float c = std::abs(std::cos(angle));
+	const float s = std::abs(std::sin(angle));
+	const glm::vec2 extent(half.x * c + half.y * s, half.x * s + half.y * c);
+	return FloatRect(mCenter - extent, extent * 2.f);
+}
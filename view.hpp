@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "rect.hpp"
+
+/**
+ * 2D camera: the area of the world shown by a RenderTarget.
+ *
+ * The rotation is in degrees, a zoom bigger than one magnifies.
+ */
+class View
+{
+public:
+	View();
+	View(glm::vec2 center, glm::vec2 size);
+	explicit View(const FloatRect &rect);
+
+	glm::vec2 getCenter() const;
+	void setCenter(glm::vec2 center);
+
+	glm::vec2 getSize() const;
+	void setSize(glm::vec2 size);
+
+	float getZoom() const;
+	void setZoom(float zoom);
+
+	float getRotation() const;
+	void setRotation(float rotation);
+
+	void move(glm::vec2 offset);
+	void reset(const FloatRect &rect);
+
+	/**
+	 * Get the orthographic projection of the zoomed view size.
+	 */
+	glm::mat4 getProjection() const;
+
+	/**
+	 * Get the rotation and translation of the view.
+	 */
+	glm::mat4 getViewMatrix() const;
+
+	/**
+	 * Get the axis aligned bounding box of the visible area.
+	 */
+	FloatRect getBounds() const;
+
+private:
+	glm::vec2 mCenter;
+	glm::vec2 mSize;
+	float     mZoom;
+	float     mRotation;
+};
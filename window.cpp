@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include "glcheck.hpp"
+#include "glstate.hpp"
 #include "window.hpp"
 
 Window::Window()
@@ -46,8 +47,8 @@ Window::open(const std::string &title, unsigned width, unsigned height)
 
 	glfwSwapInterval(1);
 	glCheck(glEnable(GL_CULL_FACE));
-	glCheck(glEnable(GL_BLEND));
-	glCheck(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+	GLState::enableBlend(true);
+	GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glCheck(glClearColor(0.f, 0.2f, 0.4f, 1.0f));
 }
 
@@ -4,11 +4,18 @@
 #include <memory>
 #include <vector>
 
+#include "atlas.hpp"
+#include "frame.hpp"
 #include "rendertarget.hpp"
 #include "resources.hpp"
 #include "resourceholder.hpp"
 #include "font.hpp"
+#include "particlesystem.hpp"
+#include "postprocessor.hpp"
 #include "texture.hpp"
+#include "texturearray.hpp"
+#include "textureloader.hpp"
+#include "tilemap.hpp"
 #include "statestack.hpp"
 
 #define INPUT_UP    0x01
@@ -17,13 +24,6 @@
 #define INPUT_RIGHT 0x08
 #define INPUT_SPACE 0x10
 
-struct Frame
-{
-	glm::vec2 size;
-	glm::vec2 uvPos;
-	glm::vec2 uvSize;
-};
-
 struct EnemyBullet
 {
 	glm::vec2 pos;
@@ -118,6 +118,12 @@ struct World
 
 	std::unique_ptr<Window> window;
 	TextureHolder textures;
+	TextureLoader loader;
+	TextureArray sprites;
+	Atlas atlas;
+	TileMap map;
+	ParticleSystem debris;
+	PostProcessor post;
 	FontHolder fonts;
 	StateStack states;
 };